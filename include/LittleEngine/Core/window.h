@@ -61,6 +61,8 @@ namespace LittleEngine
 		WindowMode mode;
 		bool vsyncEnabled;
 
+		unsigned int eventCount = 0;	// number of input / window events received, used to detect idle frames
+
 		// =========
 		// Callbacks
 		Callbacks::Window::Resize windowResizeCallback = nullptr;
@@ -82,6 +84,7 @@ namespace LittleEngine
 			height = 720;
 			mode = WindowMode::ResizableWindowed;
 			vsyncEnabled = true;
+			eventCount = 0;
 			windowResizeCallback = nullptr;
 			windowFocusCallback = nullptr;
 			windowCloseCallback = nullptr;
@@ -104,6 +107,12 @@ namespace LittleEngine
 
 		virtual void OnUpdate() = 0;
 
+		// Blocks until an event arrives or the timeout (in seconds, <= 0 waits forever) expires.
+		virtual void WaitEvents(double timeout) = 0;
+
+		// Wakes up a thread blocked in WaitEvents (can be called from any thread).
+		virtual void PostEmptyEvent() = 0;
+
 
 		// =======
 		// Setters
@@ -120,6 +129,7 @@ namespace LittleEngine
 		virtual bool ShouldClose() const = 0;
 		virtual void* GetNativeWindowHandle() = 0; // returns the native window handle, if applicable (e.g. GLFWwindow* for GLFW)
 		virtual void* GetNativeContext() = 0; // returns the native context handle, if applicable (e.g. SDL_GLContext for SDL2)
+		virtual unsigned int GetEventCount() const = 0; // number of input / window events received so far
 
 
 		// =========
@@ -64,6 +64,9 @@ namespace LittleEngine::Graphics
 
 
 		glm::vec2 ScreenToWorld(const glm::vec2& screenPos) const;
+
+		// Returns the world rectangle {min x, min y, max x, max y} seen by the camera.
+		glm::vec4 GetVisibleBounds() const;
 	};
 
 
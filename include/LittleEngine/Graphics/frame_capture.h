@@ -0,0 +1,146 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace LittleEngine::Graphics
+{
+
+	enum class CaptureFormat
+	{
+		Png,	// one png file per frame (frame_000000.png, ...)
+		Raw		// all frames appended to capture.rgba (RGBA8, top row first), see capture.txt for the size
+	};
+
+
+	/**
+	 * Reads frames back without stalling the render thread.
+	 *
+	 * glReadPixels writes into a ring of pixel buffer objects guarded by fences, the buffers
+	 * are mapped a frame or two later once the GPU is done. The rows are flipped and the
+	 * images encoded and written on a background thread.
+	 *
+	 * Update() has to be called once per frame (Renderer::EndFrame does it for the renderer capture).
+	 */
+	class FrameCapture
+	{
+	public:
+		FrameCapture() {};
+		~FrameCapture() { Shutdown(); }
+
+		FrameCapture(FrameCapture& other) = delete;
+		FrameCapture(FrameCapture&& other) = delete;
+		FrameCapture operator=(FrameCapture other) = delete;
+		FrameCapture operator=(FrameCapture& other) = delete;
+		FrameCapture operator=(FrameCapture&& other) = delete;
+
+		/**
+		 * @param: bufferCount: number of pixel buffers in flight (2 = double buffered).
+		 * @param: maxQueuedFrames: frames waiting for the writer thread above which recorded frames are dropped.
+		 */
+		void Initialize(int bufferCount = 2, size_t maxQueuedFrames = 8);
+
+		// Finishes the pending readbacks, waits for the writer thread and releases the buffers.
+		void Shutdown();
+
+		/**
+		 * Starts the readback of the currently bound framebuffer, it is saved as screenshots/<name><n>.png.
+		 *
+		 * @param: size: size of the framebuffer.
+		 * @param: isScreen: true for the default framebuffer (read from the back buffer).
+		 */
+		void CaptureScreenshot(const glm::ivec2& size, bool isScreen, const std::string& name = "screenshot");
+
+#pragma region Recording
+
+		/**
+		 * Starts recording: every frameInterval frames, CaptureFrame() saves the frame to the directory.
+		 */
+		void StartRecording(const std::string& directory, CaptureFormat format = CaptureFormat::Png, int frameInterval = 1);
+		void StopRecording();
+		bool IsRecording() const { return m_recording; }
+
+		// Starts the readback of the currently bound framebuffer if a frame has to be recorded.
+		void CaptureFrame(const glm::ivec2& size, bool isScreen);
+
+		// Number of recorded frames dropped because the writer thread could not keep up.
+		size_t GetDroppedFrameCount() const { return m_droppedFrames; }
+
+#pragma endregion
+
+		// Collects the finished readbacks and hands them to the writer thread.
+		void Update();
+
+		// Number of frames in flight (readback or writing).
+		size_t GetPendingCount();
+
+	private:
+
+		enum class JobType { Screenshot, PngFrame, RawFrame, EndStream };	// EndStream closes the raw stream
+
+		struct Job
+		{
+			JobType type = JobType::Screenshot;
+			std::string path;					// file (frames) or name prefix (screenshots)
+			glm::ivec2 size = { 0, 0 };
+			std::vector<unsigned char> pixels;	// RGBA8, bottom row first
+		};
+
+		struct Readback
+		{
+			GLuint pbo = 0;
+			size_t capacity = 0;				// size of the pbo in bytes
+			GLsync fence = nullptr;
+			unsigned long long sequence = 0;	// submission order
+			Job job;
+		};
+
+		// issues glReadPixels into a free pixel buffer.
+		void StartReadback(Job&& job, bool isScreen);
+
+		// maps a finished pixel buffer and queues the job. If wait is true, blocks until the GPU is done.
+		bool CompleteReadback(Readback& readback, bool wait);
+
+		void QueueJob(Job&& job);
+		void WriterLoop();
+		void WriteJob(Job& job);
+
+		bool m_initialized = false;
+
+		std::vector<Readback> m_readbacks;
+		unsigned long long m_sequence = 0;
+
+		// recording
+		bool m_recording = false;
+		std::string m_recordDirectory;
+		CaptureFormat m_recordFormat = CaptureFormat::Png;
+		int m_frameInterval = 1;
+		unsigned long long m_frameCounter = 0;
+		unsigned long long m_recordedFrames = 0;
+		size_t m_droppedFrames = 0;
+
+		// writer thread
+		std::thread m_writer;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::deque<Job> m_jobs;
+		size_t m_maxQueuedFrames = 8;
+		bool m_writing = false;				// the writer thread is processing a job
+		bool m_stopWriter = false;
+
+		// raw stream, only used by the writer thread
+		std::ofstream m_rawStream;
+		std::string m_rawStreamPath;
+		glm::ivec2 m_rawStreamSize = { 0, 0 };
+	};
+
+}
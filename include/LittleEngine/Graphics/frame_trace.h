@@ -0,0 +1,202 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LittleEngine/Graphics/camera.h"
+#include "LittleEngine/Graphics/color.h"
+#include "LittleEngine/Graphics/render_target.h"
+#include "LittleEngine/Graphics/texture.h"
+
+
+namespace LittleEngine::Graphics
+{
+	class Renderer;
+	struct Vertex;
+	struct RenderView;
+
+
+	enum class TraceCommandType : unsigned char
+	{
+		SetRenderTarget,	// a: target index, -1 = screen
+		Clear,				// color
+		SetBlendMode,		// a: Renderer::BlendMode
+		SetScissor,			// rect
+		DisableScissor,
+		Flush,				// a: camera index, quads [firstQuad, firstQuad + quadCount)
+		Blit,				// a: texture index, value: sharpness
+		MergeLightScene,	// a: scene texture index, b: light texture index
+		FlushViews			// a: first view, b: view count, quads [firstQuad, firstQuad + quadCount)
+	};
+
+
+	/**
+	 * Submission stream of one frame: the commands sent to the Renderer and the resources they reference.
+	 * Recorded by Renderer::CaptureFrameCommands, replayed with FrameTracePlayer.
+	 */
+	struct FrameTrace
+	{
+		struct TextureData
+		{
+			int width = 0;
+			int height = 0;
+			int channelCount = 4;				// 1 for fonts (alpha only), 4 otherwise
+			bool pixelated = false;
+			int renderTarget = -1;				// texture of a render target of the trace (no pixels), -1 otherwise
+			std::vector<unsigned char> pixels;
+		};
+
+		struct TargetData
+		{
+			glm::ivec2 size = { 0, 0 };
+			GLenum format = GL_RGB;
+			bool depthStencil = false;
+		};
+
+		struct QuadVertex
+		{
+			glm::vec2 pos;
+			glm::vec2 uv;
+			Color color;
+		};
+
+		struct Quad
+		{
+			QuadVertex vertices[4];
+			unsigned int texture = 0;
+			float layer = 0.f;
+			bool opaque = false;
+			bool clipped = false;
+			glm::vec4 clipRect = {};			// {min x, min y, max x, max y} if clipped (Renderer::PushClipRect)
+		};
+
+		struct View
+		{
+			unsigned int camera = 0;
+			glm::ivec4 viewport = { 0, 0, 0, 0 };
+			bool cull = true;
+		};
+
+		struct Command
+		{
+			TraceCommandType type = TraceCommandType::Flush;
+			int a = 0;
+			int b = 0;
+			float value = 0.f;
+			glm::vec4 data = {};				// clear color or scissor rect
+			unsigned int firstQuad = 0;
+			unsigned int quadCount = 0;
+		};
+
+		glm::ivec2 screenSize = { 0, 0 };
+		std::vector<TextureData> textures;
+		std::vector<TargetData> targets;
+		std::vector<Camera> cameras;
+		std::vector<Quad> quads;
+		std::vector<View> views;
+		std::vector<Command> commands;
+
+		bool Save(const std::string& path) const;
+		bool Load(const std::string& path);
+
+		// Checks that every index of the trace is in range.
+		bool Validate() const;
+
+		void Clear() { *this = FrameTrace{}; }
+	};
+
+
+	/**
+	 * Builds a FrameTrace from the Renderer calls, owned by the Renderer.
+	 * Textures are read back the first time they are referenced (slow, capture only).
+	 */
+	class FrameTraceRecorder
+	{
+	public:
+
+		/**
+		 * Starts a new trace with the current state of the renderer.
+		 */
+		void Begin(const glm::ivec2& screenSize, RenderTarget* target, int blendMode);
+
+		// Stops the recording and writes the trace to the file.
+		bool End(const std::string& path);
+
+		bool IsRecording() const { return m_recording; }
+
+		void RecordSetRenderTarget(RenderTarget* target);
+		void RecordClear(const Color& color);
+		void RecordSetBlendMode(int blendMode);
+		void RecordSetScissor(const glm::ivec4& rect);
+		void RecordDisableScissor();
+		void RecordFlush(const Camera& camera, const Vertex* vertices, const Texture* textures, const unsigned char* opaque, const glm::vec4* clipRects, size_t quadCount);
+		void RecordFlushViews(const std::vector<RenderView>& views, const Vertex* vertices, const Texture* textures, const unsigned char* opaque, const glm::vec4* clipRects, size_t quadCount);
+		void RecordBlit(const Texture& texture, float sharpness);
+		void RecordMergeLightScene(const Texture& scene, const Texture& light);
+
+	private:
+
+		// adds the quads to the trace, returns the index of the first one.
+		unsigned int RecordQuads(const Vertex* vertices, const Texture* textures, const unsigned char* opaque, const glm::vec4* clipRects, size_t quadCount);
+
+		// returns the index of the texture in the trace, reads it back if it was not referenced yet.
+		unsigned int GetTextureIndex(const Texture& texture);
+
+		bool m_recording = false;
+
+		FrameTrace m_trace = {};
+		std::unordered_map<GLuint, unsigned int> m_textureIndices;			// gl texture -> trace texture
+		std::unordered_map<const RenderTarget*, int> m_targetIndices;		// render target -> trace target
+	};
+
+
+	/**
+	 * Re-executes a recorded frame against a renderer, to benchmark it without the game.
+	 *
+	 *	 FrameTrace trace;
+	 *	 trace.Load("frame.letrace");
+	 *	 FrameTracePlayer player;
+	 *	 player.Initialize(trace);
+	 *	 for (int i = 0; i < 100; i++) player.Replay(&renderer);
+	 */
+	class FrameTracePlayer
+	{
+	public:
+		FrameTracePlayer() {};
+		~FrameTracePlayer() { Shutdown(); }
+
+		FrameTracePlayer(FrameTracePlayer& other) = delete;
+		FrameTracePlayer(FrameTracePlayer&& other) = delete;
+		FrameTracePlayer operator=(FrameTracePlayer other) = delete;
+		FrameTracePlayer operator=(FrameTracePlayer& other) = delete;
+		FrameTracePlayer operator=(FrameTracePlayer&& other) = delete;
+
+		// Creates the textures and render targets of the trace. The trace must outlive the player.
+		void Initialize(const FrameTrace& trace);
+		void Shutdown();
+
+		// Issues the commands of the trace, the renderer state (target, camera, blend mode, layer) is restored afterward.
+		void Replay(Renderer* renderer);
+
+		// Render target of the trace recreated by the player (to inspect or save the result of a replay).
+		RenderTarget* GetTarget(size_t index) { return index < m_targets.size() ? m_targets[index].get() : nullptr; }
+
+	private:
+
+		const Texture& GetTexture(unsigned int index) const;
+
+		bool m_initialized = false;
+
+		const FrameTrace* m_trace = nullptr;
+		std::vector<Texture> m_textures;
+		std::vector<std::unique_ptr<RenderTarget>> m_targets;
+		Camera m_camera = {};
+		std::vector<Camera> m_viewCameras;		// cameras of the views of the current FlushViews
+	};
+
+}
@@ -2,12 +2,15 @@
 
 
 #include <LittleEngine/Math/geometry.h>
+#include <LittleEngine/Math/spatial_hash_grid.h>
 #include <LittleEngine/Graphics/shader.h>
 #include <LittleEngine/Graphics/render_target.h>
 #include <LittleEngine/Graphics/camera.h>
 #include <LittleEngine/Graphics/color.h>
 #include <LittleEngine/Graphics/renderer.h>
+#include <LittleEngine/Utils/thread_pool.h>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
@@ -27,15 +30,27 @@ namespace LittleEngine::Graphics
 		glm::vec3 color = { 1.f, 1.f, 1.f };
 		float intensity = 1.f;
 		float radius = 1.f;
+		bool castShadows = true;	// false: never shadowed, evaluated by the tiled pass when tiled lighting is enabled
 
 
-		std::vector<ShadowQuad> GetShadowQuads(const Math::Polygon& poly) const;
+		// One quad per edge facing the light (two for the edges seen under more than 90 degrees), clipped to
+		// the light radius: edges out of the light are skipped. If the polygon is convex (Polygon::IsConvex), a single quad is
+		// extruded from its silhouette instead: same shadow outside of the obstacle, the part of the obstacle
+		// in front of its silhouette chord stays lit.
+		std::vector<ShadowQuad> GetShadowQuads(const Math::Polygon& poly, bool convex = false) const;
 	};
 
 
 	// Returns a vector containing the vertices of the shadow triangles ready for rendering.
 	std::vector<glm::vec2> GetShadowTriangles(const std::vector<ShadowQuad>& shadowQuads);
 
+	enum class ShadowTechnique
+	{
+		Geometry,	// shadow quads extruded from the obstacle edges on the CPU, cost grows with lights x obstacle edges
+		PolarMap,	// 1D polar depth map per light computed on the GPU, cost grows with lights x map resolution
+		VisibilityPolygon	// lit area of each light computed on the CPU by an angular sweep, drawn as a single fan
+	};
+
 	class LightSystem
 	{
 	public:
@@ -48,14 +63,64 @@ namespace LittleEngine::Graphics
 		LightSystem operator=(LightSystem& other) = delete;
 		LightSystem operator=(LightSystem&& other) = delete;
 
-		void Initialize(size_t maxQuadCount = 1000);
+		/**
+		 * @param: workerCount: threads generating the shadow geometry (precomputed shadows, visibility
+		 * polygons) with the calling thread, -1: one per core besides the calling thread.
+		 */
+		void Initialize(size_t maxQuadCount = 1000, int workerCount = -1);
 		void Shutdown();
 
 #pragma region Light and shadow rendering
 
+		/**
+		 * Renders the lights (and their shadows) additively into the target, cleared with the ambient color.
+		 * If the target has a stencil buffer (RenderTarget::Create with depthStencil), the shadows are written
+		 * to it and mask the lights directly, otherwise each shadowed light goes through a temporary target.
+		 */
 		void RenderLighting(Renderer* renderer, RenderTarget* target, bool enableShadows = true, const Color& color = Colors::Black);
+
+		/**
+		 * Same as RenderLighting, with the shadow geometry of each light kept in its own GPU buffer between frames.
+		 * Calls UpdatePrecomputedShadows first: only the lights which were added, moved or resized, or
+		 * with an obstacle changed in their square, generate and upload their shadows again.
+		 */
 		void RenderPrecomputedLighting(Renderer* renderer, RenderTarget* target, bool enableShadows = true, const Color& color = Colors::Black);
 
+		/**
+		 * Enables tiled lighting for the lights without shadows (LightSource::castShadows = false,
+		 * every light if shadows are disabled or if there is no obstacle).
+		 *
+		 * Instead of a pass per light (clear, light quad, additive blit), these lights are binned into
+		 * screen tiles of tileSize pixels on the CPU and evaluated in one fullscreen pass, each pixel
+		 * only iterating over the lights touching its tile. Lights casting shadows keep their own pass.
+		 */
+		void SetTiledLighting(bool enabled, int tileSize = 32);
+		bool IsTiledLighting() const { return m_tiledLighting; }
+
+		/**
+		 * Selects how RenderLighting computes the shadows (RenderPrecomputedLighting keeps its precomputed geometry).
+		 *
+		 * With PolarMap, the obstacles are rasterized once per frame into an occlusion texture covering the
+		 * screen extended by the light radii. A shader then marches from each shadowed light in polarResolution
+		 * directions and stores the distance to the first obstacle, one row per light in a shared texture,
+		 * which the light pass compares with the distance of the pixel. Obstacles thinner than a pixel of the
+		 * occlusion texture can be missed.
+		 */
+		void SetShadowTechnique(ShadowTechnique technique, int polarResolution = 512);
+		ShadowTechnique GetShadowTechnique() const { return m_shadowTechnique; }
+
+		/**
+		 * Computes the area visible from origin within the square of half size radius (the lit area
+		 * of a light with the VisibilityPolygon technique), CCW, with an angular sweep over the
+		 * endpoints of the obstacle edges. Also usable for line of sight queries:
+		 *
+		 *	 lightSystem.ComputeVisibilityPolygon(enemy.position, viewDistance, visibility);
+		 *	 bool seen = visibility.Contains(player.position);
+		 *
+		 * Overlapping obstacles are not supported (their edges must not cross).
+		 */
+		void ComputeVisibilityPolygon(const glm::vec2& origin, float radius, Math::Polygon& polygon);
+
 #pragma endregion
 
 
@@ -73,7 +138,7 @@ namespace LittleEngine::Graphics
 		 * Deletes all light sources in the scene.
 		 * IMPORTANT: after this call, all light source pointers become invalid, do not use them anymore!
 		 */
-		void ClearLightSources() { m_lightSources.clear(); }
+		void ClearLightSources() { m_lightSources.clear(); ReleasePrecomputedShadows(); }
 		const std::vector<std::unique_ptr<LightSource>>& GetLightSources() const { return m_lightSources; }
 #pragma endregion
 
@@ -90,9 +155,44 @@ namespace LittleEngine::Graphics
 		 * Deletes all obstacles in the scene.
 		 * IMPORTANT: after this call, all obstacles pointers become invalid, do not use them anymore!
 		 */
-		void ClearObstacles() { m_obstacles.clear(); }
+		void ClearObstacles()
+		{
+			m_obstacles.clear();
+			m_obstacleGrid.Clear();
+			m_convexObstacles.clear();
+			m_edgeBufferDirty = true;
+			m_precomputedShadowsDirty = true;
+		}
 		const std::vector<std::unique_ptr<Math::Polygon>>& GetObstacles() const { return m_obstacles; }
 
+		/**
+		 * The edges of the obstacles are uploaded once to the GPU, where RenderLighting extrudes the shadows,
+		 * and their bounds are indexed in a grid. Call after modifying the vertices of an obstacle in place,
+		 * only the precomputed shadows of the lights around its old and new bounds are generated again.
+		 * MarkObstaclesDirty updates every obstacle and every precomputed shadow.
+		 */
+		void UpdateObstacle(Math::Polygon* polygon);
+		void MarkObstaclesDirty();
+
+		/**
+		 * Appends the obstacles whose bounds intersect the area, from the grid of the obstacle bounds
+		 * (each light only processes the obstacles in its radius).
+		 */
+		void QueryObstacles(const Math::AABB& area, std::vector<Math::Polygon*>& obstacles);
+
+		// Size of the cells of the obstacle grid, in world units (8 by default, a quarter of the view width).
+		// About the radius of the lights works well.
+		void SetObstacleGridCellSize(float cellSize) { m_obstacleGrid.SetCellSize(cellSize); }
+
+		/**
+		 * Generates the shadows of the dirty lights for RenderPrecomputedLighting, which calls it every frame.
+		 * A light is dirty when it was created, moved or resized, or when an obstacle was created, deleted
+		 * or updated (UpdateObstacle) in its square. Moving the vertices of an obstacle without UpdateObstacle
+		 * is not detected.
+		 */
+		void UpdatePrecomputedShadows();
+
+		// Generates the shadows of every light again.
 		void PrecomputeShadowVertices();
 
 
@@ -102,10 +202,49 @@ namespace LittleEngine::Graphics
 
 		void BatchShadows()
 		{
-			BatchVertices(m_shadowVertices);
+			BatchVertices(m_shadowVertices.data(), m_shadowVertices.size());
 			m_shadowVertices.clear(); // clear the vertices after batching
 		}
-		void BatchVertices(const std::vector<glm::vec2>& vertices);
+		void BatchVertices(const glm::vec2* vertices, size_t count);
+
+		// queries the obstacles in the square of each light of m_selectedLights into m_lightObstacles,
+		// on the calling thread before the parallel work (the grid queries are not thread safe).
+		void GatherLightObstacles();
+
+		// dirties the precomputed shadows of the lights around the bounds of a changed obstacle.
+		void RecordObstacleChange(const Math::AABB& bounds);
+
+		// deletes the precomputed shadows of all the lights and their buffers.
+		void ReleasePrecomputedShadows();
+
+		// draws a pass per light which is not tiled, precomputed: uses the shadows of UpdatePrecomputedShadows.
+		void RenderLightPasses(Renderer* renderer, RenderTarget* target, bool enableShadows, bool precomputed);
+		void DrawLight(Renderer* renderer, const LightSource& light, const Camera& camera, const glm::ivec2& size);
+		void DrawShadows(const LightSource& light, size_t lightIndex, const Camera& camera, bool precomputed);
+
+		// draws the shadows of the light from the edge buffer, extruded by the vertex shader.
+		void DrawExtrudedShadows(const LightSource& light);
+		void UpdateEdgeBuffer();
+
+		// computes the visibility polygons of the shadowed lights on the workers and uploads their fans.
+		void PrepareVisibilityFans(const Camera& camera, const glm::ivec2& size);
+		// draws the light over its visibility polygon only ({first, count} in the fan buffer).
+		void DrawVisibilityLight(const LightSource& light, const Camera& camera, const glm::ivec2& size, const glm::uvec2& fan);
+
+		// rasterizes the obstacles and computes the polar map of the shadowed lights (rows in m_polarRows),
+		// returns a target of the renderer pool, nullptr if no light needs one.
+		RenderTarget* RenderPolarShadowMap(Renderer* renderer, RenderTarget* target);
+		void DrawPolarLight(Renderer* renderer, const LightSource& light, const Camera& camera, const glm::ivec2& size, const Texture& polarMap, int row);
+
+		// true if the light is drawn by the tiled pass instead of its own pass.
+		bool IsTiled(const LightSource& light, bool enableShadows) const
+		{
+			return m_tiledLighting && (!enableShadows || !light.castShadows || m_obstacles.empty());
+		}
+
+		// bins the tiled lights into the screen tiles of the target and draws them in one additive pass.
+		void RenderTiledLights(Renderer* renderer, RenderTarget* target, bool enableShadows);
+		void BinLights(const Camera& camera, const glm::ivec2& size, bool enableShadows);
 
 		bool m_initialized = false; // true if the light system is initialized
 
@@ -123,13 +262,84 @@ namespace LittleEngine::Graphics
 		Shader m_shadowShader = {};
 		Shader m_lightShader = {};
 
-		RenderTarget m_tempLightFBO = {};
-
 		std::vector<glm::vec2> m_shadowVertices; // vertices for shadow rendering
 
-
-		// precompute all shadow vertices for each light source and obstacle
-		std::vector<std::vector<std::vector<glm::vec2>>> m_verticesLightBatches; // shadow vertices for each light source
+		// edges {p1, p2} of all the obstacles, one instance per edge, extruded away from the light on the GPU.
+		GLuint m_edgeVAO = 0;
+		GLuint m_edgeVBO = 0;
+		Shader m_edgeShadowShader = {};
+		bool m_edgeBufferDirty = true;
+		size_t m_edgeCapacity = 0;
+		std::vector<glm::vec4> m_edges;
+		std::unordered_map<const Math::Polygon*, glm::uvec2> m_edgeRanges;	// {first, count} of the edges of each obstacle
+		std::vector<glm::uvec2> m_drawRanges;
+
+		// obstacles by area, the lights query their square
+		Math::SpatialHashGrid<Math::Polygon*> m_obstacleGrid{ 8.f };
+		bool m_obstacleGridDirty = false;
+		std::vector<Math::Polygon*> m_queryObstacles;
+
+
+		// precomputed shadows of each light source (same index as m_lightSources), with the position
+		// and radius they were generated for. The vertices only live in the buffer of the light,
+		// drawn through m_precomputedVAO.
+		struct PrecomputedShadows
+		{
+			glm::vec2 position = { 0.f, 0.f };
+			float radius = -1.f;	// < 0: not generated yet
+			GLuint buffer = 0;
+			size_t capacity = 0;	// in vertices
+			size_t vertexCount = 0;
+		};
+		std::vector<PrecomputedShadows> m_precomputedShadows;
+		std::vector<std::vector<glm::vec2>> m_dirtyShadowVertices;	// generated by the workers for the upload, same index as m_dirtyLights
+		GLuint m_precomputedVAO = 0;
+		std::vector<Math::AABB> m_changedObstacleBounds;	// old and new bounds of the obstacles changed since the last update
+		bool m_precomputedShadowsDirty = true;				// every light
+		std::unordered_map<const Math::Polygon*, bool> m_convexObstacles;
+
+		// parallel shadow geometry: the obstacles of each light are gathered first, then each worker
+		// writes the geometry of its lights.
+		Utils::ThreadPool m_workers;
+		std::vector<unsigned char> m_selectedLights;
+		std::vector<unsigned int> m_dirtyLights;		// indices of the selected lights for the precomputed shadows
+		std::vector<Math::Polygon*> m_lightObstacles;
+		std::vector<glm::uvec2> m_lightObstacleRanges;	// {first, count} in m_lightObstacles of each light
+
+		// tiled lighting, the tables are read by the shader from texture buffers.
+		bool m_tiledLighting = false;
+		int m_tileSize = 32;
+		Shader m_tiledLightShader = {};
+
+		GLuint m_lightDataBuffer = 0;
+		GLuint m_lightDataTexture = 0;
+		GLuint m_tileRangeBuffer = 0;
+		GLuint m_tileRangeTexture = 0;
+		GLuint m_tileLightBuffer = 0;
+		GLuint m_tileLightTexture = 0;
+
+		std::vector<glm::vec4> m_lightData;				// 2 texels per light: {position, radius, intensity}, {color, 0}
+		std::vector<glm::ivec4> m_lightTiles;			// tiles {x0, y0, x1, y1} covered by each light of m_lightData
+		std::vector<glm::uvec2> m_tileRanges;			// {first, count} of the lights of each tile in m_tileLightIndices
+		std::vector<unsigned int> m_tileLightIndices;	// lights of the tiles, tile after tile
+
+		// polar shadow maps, the light data is uploaded to m_lightDataBuffer with the layout of m_lightData.
+		ShadowTechnique m_shadowTechnique = ShadowTechnique::Geometry;
+		int m_polarResolution = 512;
+		Shader m_polarMapShader = {};
+		Shader m_polarLightShader = {};
+
+		std::vector<int> m_polarRows;					// row of each light source in the polar map, -1 if none
+
+		// visibility polygons
+		Shader m_visibilityLightShader = {};
+		GLuint m_fanVAO = 0;
+		GLuint m_fanVBO = 0;
+		std::vector<glm::vec2> m_fanVertices;
+		std::vector<glm::uvec2> m_fanRanges;			// {first, count} of the fan of each light, count = 0 if none
+		std::vector<Math::Edge> m_visibilityEdges;		// edges clipped to the square of the light
+		std::vector<float> m_visibilityAngles;			// {begin, end} angle of each edge
+		std::vector<unsigned int> m_visibilityEvents;	// edge ends sorted by angle
 
 	};
 
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "LittleEngine/Graphics/renderer.h"
+#include "LittleEngine/Graphics/shader.h"
+#include "LittleEngine/Graphics/texture.h"
+
+
+namespace LittleEngine::Graphics
+{
+
+	enum class PostProcessStage
+	{
+		LightMerge,		// multiplies the scene by the light texture (same as Renderer::MergeLightScene)
+		ToneMap,		// exposure tone mapping of the HDR color to [0, 1]
+		ColorGrade,		// contrast, brightness, saturation and tint
+		Vignette,		// darkens the borders
+		Sharpen			// unsharp mask (same as Renderer::BlitImage with sharpness), reads neighbouring pixels
+	};
+
+
+	// Parameters of the stages, can be changed every frame without rebuilding the shaders.
+	struct PostProcessSettings
+	{
+		float exposure = 1.f;
+
+		float contrast = 1.f;
+		float brightness = 0.f;
+		float saturation = 1.f;
+		glm::vec3 tint = { 1.f, 1.f, 1.f };
+
+		float vignetteIntensity = 0.5f;		// 0 = no vignette, 1 = black corners
+		float vignetteRadius = 0.75f;		// distance from the center (1 = corner) where the darkening ends
+		float vignetteSoftness = 0.45f;		// width of the transition
+
+		float sharpness = 0.5f;
+	};
+
+
+	/**
+	 * Chain of fullscreen effects applied to the scene when it is composed to the screen.
+	 *
+	 * At Initialize, consecutive stages are fused into a single generated fragment shader,
+	 * so each extra effect costs a few instructions instead of a fullscreen read and write.
+	 * A stage reading neighbouring pixels (Sharpen) can only be fused as the first stage
+	 * of a pass: if it comes later, a new pass starts with an intermediate target (from the renderer pool).
+	 *
+	 * The last pass draws to the current render target of the renderer at its size, which
+	 * also upscales a scene rendered at a lower resolution (see ResolutionScaler).
+	 *
+	 *	 postProcess.Initialize({ PostProcessStage::Sharpen, PostProcessStage::LightMerge, PostProcessStage::ToneMap, PostProcessStage::Vignette });
+	 *	 ...
+	 *	 renderer.SetRenderTarget();	// screen
+	 *	 postProcess.Apply(&renderer, scene.GetTexture(), light.GetTexture());	// one pass
+	 */
+	class PostProcessStack
+	{
+	public:
+		PostProcessStack() {};
+		~PostProcessStack() { Shutdown(); }
+
+		PostProcessStack(PostProcessStack& other) = delete;
+		PostProcessStack(PostProcessStack&& other) = delete;
+		PostProcessStack operator=(PostProcessStack other) = delete;
+		PostProcessStack operator=(PostProcessStack& other) = delete;
+		PostProcessStack operator=(PostProcessStack&& other) = delete;
+
+		/**
+		 * Builds the shaders of the chain.
+		 *
+		 * @param: stages: effects in the order they are applied.
+		 */
+		void Initialize(const std::vector<PostProcessStage>& stages, const PostProcessSettings& settings = {});
+		void Shutdown();
+
+		PostProcessSettings& GetSettings() { return m_settings; }
+
+		/**
+		 * Applies the chain to the scene and draws the result to the current render target of the renderer.
+		 *
+		 * @param: light: light texture, required if the chain has a LightMerge stage.
+		 */
+		void Apply(Renderer* renderer, const Texture& scene, const Texture& light = {});
+
+		// Number of fullscreen passes drawn by Apply.
+		size_t GetPassCount() const { return m_passes.size(); }
+
+		// Generated fragment shader of a pass (debug).
+		const std::string& GetPassSource(size_t pass) const { return m_passes[pass].source; }
+
+	private:
+
+		struct Pass
+		{
+			std::vector<PostProcessStage> stages;
+			std::string source;
+			Shader shader = {};
+			bool usesLight = false;
+		};
+
+		static bool ReadsNeighbours(PostProcessStage stage) { return stage == PostProcessStage::Sharpen; }
+
+		// generates the fragment shader running the stages one after the other.
+		static std::string GenerateFragmentShader(const std::vector<PostProcessStage>& stages);
+
+		void SetUniforms(const Shader& shader) const;
+
+		bool m_initialized = false;
+
+		PostProcessSettings m_settings = {};
+		std::vector<Pass> m_passes;
+	};
+
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "LittleEngine/Graphics/color.h"
+#include "LittleEngine/Graphics/render_target.h"
+#include "LittleEngine/Graphics/renderer.h"
+
+
+namespace LittleEngine::Graphics
+{
+
+	// Handle to a resource of a RenderGraph, only valid until the next RenderGraph::Reset().
+	using RenderGraphHandle = int;
+	constexpr RenderGraphHandle InvalidRenderGraphHandle = -1;
+
+	// What happens to the content of the output of a pass before it executes.
+	enum class LoadOp
+	{
+		Load,		// keep the previous content (e.g. additive light accumulation), cleared at the first use of a transient target
+		Clear,		// clear with the pass clear color
+		DontCare	// the pass overwrites every pixel (e.g. fullscreen blit), no clear needed
+	};
+
+	struct RenderGraphStats
+	{
+		int passCount = 0;				// passes added to the graph
+		int culledPassCount = 0;		// passes not contributing to an output
+		int transientCount = 0;			// transient targets used by the executed passes
+		int physicalTargetCount = 0;	// render targets actually backing them
+		int skippedBinds = 0;			// target binds avoided during the last Execute
+		int skippedClears = 0;			// clears avoided during the last Execute
+		size_t transientMemory = 0;		// bytes used by the physical targets
+		size_t unaliasedMemory = 0;		// bytes that would be used without aliasing
+	};
+
+
+	/**
+	 * Describes a frame as a list of passes with declared inputs and outputs.
+	 *
+	 * Each frame: Reset(), declare the targets (transient ones are owned by the graph, imported
+	 * ones by the user, nullptr being the screen), add the passes in execution order, then Execute().
+	 *
+	 * At compile time the passes which do not contribute to an imported target (or a target marked
+	 * with MarkOutput) are culled, and transient targets whose lifetimes do not overlap share the
+	 * same physical RenderTarget when their size and format match.
+	 * Physical targets come from the renderer RenderTargetPool, so an unchanged graph does not allocate.
+	 *
+	 * Example (lighting composition):
+	 *		graph.Reset();
+	 *		auto scene = graph.CreateTarget("scene", size);
+	 *		auto light = graph.CreateTarget("light", size, GL_RGB16F);
+	 *		auto screen = graph.ImportTarget("screen", nullptr);
+	 *		graph.AddPass("scene", {}, scene, LoadOp::Clear, [&](Renderer* r, RenderGraph&) { ... });
+	 *		graph.AddPass("light", {}, light, LoadOp::DontCare, [&](Renderer* r, RenderGraph& g) { lights.RenderLighting(r, g.GetTarget(light)); });
+	 *		graph.AddPass("merge", { scene, light }, screen, LoadOp::DontCare, [&](Renderer* r, RenderGraph& g) { r->MergeLightScene(g.GetTexture(scene), g.GetTexture(light)); });
+	 *		graph.Execute();
+	 */
+	class RenderGraph
+	{
+	public:
+		using ExecuteFunction = std::function<void(Renderer*, RenderGraph&)>;
+
+		RenderGraph() {};
+		~RenderGraph() { Shutdown(); }
+
+		RenderGraph(RenderGraph& other) = delete;
+		RenderGraph(RenderGraph&& other) = delete;
+		RenderGraph operator=(RenderGraph other) = delete;
+		RenderGraph operator=(RenderGraph& other) = delete;
+		RenderGraph operator=(RenderGraph&& other) = delete;
+
+		void Initialize(Renderer* renderer);
+		void Shutdown();
+
+		// Removes all passes and resources to describe a new frame (physical targets are kept).
+		void Reset();
+
+#pragma region Resources
+
+		// Declares a target owned by the graph, only allocated if a pass which is not culled uses it.
+		RenderGraphHandle CreateTarget(const std::string& name, const glm::ivec2& size, GLenum internalFormat = GL_RGB);
+
+		/**
+		 * Declares a target owned by the user.
+		 * Imported targets are outputs of the graph: the passes writing them are never culled.
+		 *
+		 * @param: target: the render target, nullptr for the screen.
+		 */
+		RenderGraphHandle ImportTarget(const std::string& name, RenderTarget* target);
+
+		// Keeps the passes writing a transient target even if no pass reads it.
+		void MarkOutput(RenderGraphHandle handle);
+
+		// Returns the render target backing the resource (nullptr for the screen). Only valid during Execute().
+		RenderTarget* GetTarget(RenderGraphHandle handle);
+
+		// Returns the texture of the resource, the resource cannot be the screen. Only valid during Execute().
+		const Texture& GetTexture(RenderGraphHandle handle);
+
+#pragma endregion
+
+#pragma region Passes
+
+		/**
+		 * Adds a pass, passes are executed in the order they are added.
+		 *
+		 * @param: inputs: resources sampled by the pass.
+		 * @param: output: resource the pass renders to, bound before execute is called.
+		 * @param: loadOp: what to do with the previous content of the output.
+		 * @param: execute: records the draws of the pass.
+		 * @param: clearColor: color used when loadOp is LoadOp::Clear.
+		 */
+		void AddPass(const std::string& name, const std::vector<RenderGraphHandle>& inputs, RenderGraphHandle output,
+			LoadOp loadOp, const ExecuteFunction& execute, const Color& clearColor = Colors::Black);
+
+#pragma endregion
+
+		// Culls the passes and assigns physical targets. Called by Execute() if needed.
+		bool Compile();
+
+		// Executes the passes which were not culled, then restores the previous render target.
+		void Execute();
+
+		const RenderGraphStats& GetStats() const { return m_stats; }
+
+	private:
+
+		struct Resource
+		{
+			std::string name;
+			glm::ivec2 size = { 0, 0 };
+			GLenum format = GL_RGB;
+			RenderTarget* imported = nullptr;	// target of an imported resource (nullptr = screen)
+			bool isImported = false;
+			bool isOutput = false;
+
+			// compile results
+			int firstUse = -1;					// index in m_executionOrder
+			int lastUse = -1;
+			int physical = -1;					// index in m_physicalTargets
+		};
+
+		struct Pass
+		{
+			std::string name;
+			std::vector<RenderGraphHandle> inputs;
+			RenderGraphHandle output = InvalidRenderGraphHandle;
+			LoadOp loadOp = LoadOp::Load;
+			Color clearColor = Colors::Black;
+			ExecuteFunction execute;
+		};
+
+		struct PhysicalTarget
+		{
+			RenderTarget* target = nullptr;		// acquired from the renderer pool
+			glm::ivec2 size = { 0, 0 };
+			GLenum format = GL_RGB;
+			int busyUntil = -1;					// last use of the resource currently aliased to it
+		};
+
+		// gives the physical targets back to the renderer pool.
+		void ReleasePhysicalTargets();
+
+		bool IsValid(RenderGraphHandle handle) const { return handle >= 0 && handle < static_cast<int>(m_resources.size()); }
+
+		bool m_initialized = false;
+		bool m_compiled = false;
+
+		Renderer* m_renderer = nullptr;
+
+		std::vector<Resource> m_resources;
+		std::vector<Pass> m_passes;
+		std::vector<int> m_executionOrder;		// indices of the passes to execute
+
+		std::vector<PhysicalTarget> m_physicalTargets;
+
+		RenderGraphStats m_stats = {};
+	};
+
+}
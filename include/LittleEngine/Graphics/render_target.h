@@ -14,7 +14,13 @@ namespace LittleEngine::Graphics
 	{
 	public:
 
-		bool Create(int width, int height, GLenum internalFormat = GL_RGB);			// later: bool hasDepthBuffer ??
+		/**
+		 * Creates the framebuffer and its color texture.
+		 *
+		 * @param: depthStencil: if true, a 24 bit depth / 8 bit stencil buffer is attached
+		 *         (needed for the depth-tested opaque pass of the Renderer and the stencil shadows of the LightSystem).
+		 */
+		bool Create(int width, int height, GLenum internalFormat = GL_RGB, bool depthStencil = false);
 		void Cleanup();
 
 		void Bind();
@@ -25,13 +31,20 @@ namespace LittleEngine::Graphics
 		const Texture& GetTexture() { return m_texture; }
 
 		glm::ivec2 GetSize() { return glm::ivec2(m_width, m_height); }
+		GLenum GetFormat() const { return m_format; }
+		bool HasDepthStencil() const { return m_depthStencil != 0; }
+
+		// Returns the approximate video memory used by the target, in bytes.
+		size_t GetMemoryUsage() const { return GetMemoryUsage({ m_width, m_height }, m_format) + (HasDepthStencil() ? GetMemoryUsage({ m_width, m_height }, GL_DEPTH24_STENCIL8) : 0); }
+		static size_t GetMemoryUsage(const glm::ivec2& size, GLenum internalFormat);
 
 	private:
 		Texture m_texture = {};
 		GLuint m_fbo = -1;
 		int m_width = -1;
 		int m_height = -1;
-		// GLuint m_depthBuffer; TODO add later maybe.
+		GLenum m_format = GL_RGB;
+		GLuint m_depthStencil = 0;	// depth / stencil renderbuffer, 0 if none
 
 
 	};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "LittleEngine/Graphics/render_target.h"
+
+
+namespace LittleEngine::Graphics
+{
+
+	struct RenderTargetPoolConfig
+	{
+		int maxUnusedFrames = 30;					// free targets not reused for this many frames are destroyed
+		size_t memoryBudget = 256 * 1024 * 1024;	// free targets above this memory (in bytes) are destroyed, least recently used first
+	};
+
+
+	/**
+	 * Recycles render targets by (size, format).
+	 *
+	 * Acquire() returns a free target with the same size and format if there is one,
+	 * otherwise a new one is created. Release() gives it back to the pool.
+	 * AcquireTemporary() targets are released automatically at EndFrame().
+	 *
+	 * Free targets are destroyed when they are not reused for maxUnusedFrames frames or
+	 * when the free targets exceed the memory budget, so a resize storm does not keep
+	 * a target for every intermediate size.
+	 *
+	 * The Renderer owns a pool (Renderer::GetRenderTargetPool) and ends its frame in Renderer::EndFrame.
+	 */
+	class RenderTargetPool
+	{
+	public:
+		RenderTargetPool() {};
+		~RenderTargetPool() { Shutdown(); }
+
+		RenderTargetPool(RenderTargetPool& other) = delete;
+		RenderTargetPool(RenderTargetPool&& other) = delete;
+		RenderTargetPool operator=(RenderTargetPool other) = delete;
+		RenderTargetPool operator=(RenderTargetPool& other) = delete;
+		RenderTargetPool operator=(RenderTargetPool&& other) = delete;
+
+		void Initialize(const RenderTargetPoolConfig& config = {});
+		void Shutdown();
+
+		/**
+		 * Returns a target of the given size and format, owned by the pool.
+		 * The content of the target is undefined, clear it if needed.
+		 *
+		 * @return: the target, nullptr if it could not be created.
+		 */
+		RenderTarget* Acquire(const glm::ivec2& size, GLenum internalFormat = GL_RGB);
+
+		// Same as Acquire, the target is released at the next EndFrame().
+		RenderTarget* AcquireTemporary(const glm::ivec2& size, GLenum internalFormat = GL_RGB);
+
+		// Gives the target back to the pool, the pointer must not be used afterward.
+		void Release(RenderTarget* target);
+
+		// Releases the temporary targets and destroys the targets unused for too long.
+		void EndFrame();
+
+		// Destroys all the free targets.
+		void Clear();
+
+#pragma region Statistics
+
+		// Returns the approximate video memory used by all the targets of the pool (in use or free), in bytes.
+		size_t GetMemoryUsage() const;
+		size_t GetTargetCount() const { return m_entries.size(); }
+		size_t GetUsedTargetCount() const;
+
+		// Number of targets created since Initialize (a high value means the pool is not recycling).
+		size_t GetAllocationCount() const { return m_allocationCount; }
+
+#pragma endregion
+
+	private:
+
+		struct Entry
+		{
+			std::unique_ptr<RenderTarget> target;
+			glm::ivec2 size = { 0, 0 };
+			GLenum format = GL_RGB;
+			bool inUse = false;
+			bool temporary = false;
+			unsigned long long lastUsedFrame = 0;
+		};
+
+		void Destroy(size_t index);
+
+		// destroys free targets, least recently used first, until the free memory fits the budget.
+		void EnforceBudget(size_t reserve);
+
+		bool m_initialized = false;
+		RenderTargetPoolConfig m_config = {};
+
+		std::vector<Entry> m_entries;
+
+		unsigned long long m_frame = 0;
+		size_t m_allocationCount = 0;
+	};
+
+}
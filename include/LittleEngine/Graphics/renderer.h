@@ -5,6 +5,9 @@
 #include "LittleEngine/Graphics/texture.h"
 #include "LittleEngine/Graphics/font.h"
 #include "LittleEngine/Graphics/render_target.h"
+#include "LittleEngine/Graphics/render_target_pool.h"
+#include "LittleEngine/Graphics/frame_capture.h"
+#include "LittleEngine/Graphics/frame_trace.h"
 #include "LittleEngine/Math/geometry.h"
 #include <vector>
 #include <array>
@@ -17,14 +20,25 @@ namespace LittleEngine::Graphics
 	using Rect = glm::vec4;
 
 
+	// Camera and viewport of one view drawn by Renderer::FlushViews.
+	struct RenderView
+	{
+		const Camera* camera = nullptr;
+		glm::ivec4 viewport = { 0, 0, 0, 0 };	// {x, y, w, h} in pixels of the current target, w or h = 0 uses the whole target
+		bool cull = true;						// skips the quads outside of the camera
+	};
+
+
 	struct Vertex {
 		glm::vec2 pos;
 		glm::vec2 uv;
 		Color color;
 		float textureIndex;
+		float depth;	// layer of the quad when queued, depth-buffer value when batched
+		float clipIndex;	// clip rect of the quad in the table of the flush, 0 = unclipped
 
-		Vertex(const glm::vec2& p, const glm::vec2& u, const Color& c, float tIndex)
-			: pos(p), uv(u), color(c), textureIndex(tIndex) {
+		Vertex(const glm::vec2& p, const glm::vec2& u, const Color& c, float tIndex, float d = 0.f, float clip = 0.f)
+			: pos(p), uv(u), color(c), textureIndex(tIndex), depth(d), clipIndex(clip) {
 		}
 	};
 
@@ -63,15 +77,53 @@ namespace LittleEngine::Graphics
 
 		void SetWireframe(bool b);
 
+		/**
+		 * Restricts rendering to the given rectangle of the current render target.
+		 * The quads queued before the call are flushed first, with the previous scissor.
+		 *
+		 * @param: rect: {x, y, w, h} in pixels, (x, y) is the bottom left corner.
+		 */
+		void SetScissorRect(const glm::ivec4& rect);
+		void DisableScissor();
+		bool IsScissorEnabled() const { return m_scissor; }
+		// {x, y, w, h} of the last SetScissorRect, only meaningful while the scissor is enabled.
+		const glm::ivec4& GetScissorRect() const { return m_scissorRect; }
+
+		/**
+		 * Clips the next draws to the rectangle, intersected with the current clip rect (nested scroll views, text boxes...),
+		 * until the matching PopClipRect.
+		 *
+		 * Unlike SetScissorRect, it does not flush: the clipped quads stay in the same batches as the others,
+		 * each one keeps the index of its rect in a table of the flush and is clipped in the vertex shader.
+		 * The queue is only flushed when the table is full (defaults::MAX_CLIP_RECTS - 1 rects per flush).
+		 *
+		 * @param: rect: {x, y, w, h} in world coordinates (same as DrawRect), (x, y) is the bottom left corner.
+		 */
+		void PushClipRect(const Rect& rect);
+		void PopClipRect();
+
 		// flushes a fullscreen quad to the current render target
 		// uses the current shader set by the user (shader.Use())
 		void FlushFullscreenQuad();
 
-		void BlitImage(const Texture& texture);
+		// vertex shader of the fullscreen quad (outputs TexCoords), shared by the fullscreen pass shaders.
+		static const std::string& GetFullscreenVertexShader();
+
+		/**
+		 * Draws the texture over the whole current render target (scaled to fit).
+		 *
+		 * @param: sharpness: if > 0, applies a sharpening filter, useful when upscaling
+		 *         a target rendered at a lower resolution (see ResolutionScaler).
+		 */
+		void BlitImage(const Texture& texture, float sharpness = 0.f);
 
 		void MergeLightScene(const Texture& scene, const Texture& light);
 
 
+		/**
+		 * Saves the target (or the screen) to screenshots/<name><n>.png.
+		 * Asynchronous: the file is written a few frames later by the frame capture thread.
+		 */
 		void SaveScreenshot(RenderTarget* target = nullptr, const std::string& name = "screenshot");
 
 #pragma region DRAW RECT
@@ -87,6 +139,12 @@ namespace LittleEngine::Graphics
 		}
 		void DrawRect(const Rect& rect, Texture texture, const Color& color = Colors::White, const glm::vec4& uv = { 0, 0, 1, 1 });
 
+		/**
+		 * Draws a quad from its vertices (bottom left, bottom right, top right, top left),
+		 * with the current layer and opaque flag: Vertex::textureIndex and Vertex::depth are ignored.
+		 */
+		void DrawQuad(const std::array<Vertex, 4>& vertices, Texture texture);
+
 #pragma endregion
 
 #pragma region DRAW LINE
@@ -130,25 +188,126 @@ namespace LittleEngine::Graphics
 		};
 
 		void SetBlendMode(BlendMode mode);
+		BlendMode GetBlendMode() const { return m_blendMode; }
+
+#pragma region LAYERS
+
+		/**
+		 * Sets the layer of the next draws.
+		 * Quads of a higher layer are drawn over quads of a lower layer (within a flush),
+		 * quads of the same layer keep their submission order.
+		 */
+		void SetLayer(float layer) { m_layer = layer; }
+		float GetLayer() const { return m_layer; }
+
+		/**
+		 * Marks the next draws as opaque (pixels with alpha < 0.5 are cut out, not blended).
+		 *
+		 * When the current target has a depth buffer (RenderTarget::Create with depthStencil, or the screen),
+		 * opaque quads are drawn front-to-back with depth testing so hidden pixels are not shaded,
+		 * then translucent quads are blended back-to-front. Otherwise everything is blended back-to-front.
+		 */
+		void SetOpaque(bool opaque) { m_opaque = opaque; }
+		bool IsOpaque() const { return m_opaque; }
+
+#pragma endregion
+
+#pragma region DIRTY RECT
+
+		/**
+		 * Enables dirty-rectangle rendering for the screen.
+		 *
+		 * Quads flushed to the screen are tracked by their screen-space bounds and compared
+		 * with the previous frame. At EndFrame only the union of the changed regions is redrawn
+		 * (under a scissor) into a persistent back buffer, which is then presented.
+		 * Only batched draws (DrawRect, DrawLine, DrawPolygon, DrawString) are tracked:
+		 * fullscreen passes (BlitImage, MergeLightScene) must target a RenderTarget in this mode.
+		 */
+		void SetDirtyRectMode(bool enabled);
+		bool IsDirtyRectMode() const { return m_dirtyRectMode; }
+
+		// Forces the whole screen to be redrawn at the next EndFrame.
+		void InvalidateScreen() { m_fullRedraw = true; }
+
+		// Returns the region {x, y, w, h} redrawn during the last frame (w = h = 0 if nothing changed).
+		const glm::ivec4& GetLastDirtyRegion() const { return m_lastDirtyRegion; }
+
+#pragma endregion
 
 
 		//Camera camera = {};
 		Shader shader;
 
+		// Pool of intermediate render targets, temporary targets are released at EndFrame.
+		RenderTargetPool& GetRenderTargetPool() { return m_targetPool; }
+
+		// Asynchronous screenshots and recording, while recording the screen is captured at EndFrame.
+		FrameCapture& GetFrameCapture() { return m_frameCapture; }
+
+		/**
+		 * Records the renderer commands of the next frame (BeginFrame to EndFrame) and the textures
+		 * they use into a trace file, which can be replayed with FrameTracePlayer (see tools/frame_replay).
+		 */
+		void CaptureFrameCommands(const std::string& path) { m_tracePath = path; }
+		bool IsCapturingFrameCommands() const { return m_traceRecorder.IsRecording(); }
+
 		void SetCamera(const Camera& camera) { m_camera = &camera; }
 		const Camera& GetCamera() const { return *m_camera; }
 
 		void Flush();
 
+		/**
+		 * Draws the queued quads once per view (split-screen, minimap, ...), instead of submitting them again per camera.
+		 * The quads are sorted, batched and uploaded once, only the camera and the viewport change between views.
+		 * With RenderView::cull, each view skips the chunks of quads outside of its camera.
+		 */
+		void FlushViews(const std::vector<RenderView>& views);
+
 		void BindScreen();
 	private:
 		// TODO REFACTOR AUTO FLUSH IF FULL NOT AT END
 		// FLUSH BATCH IF: > 16 textures || #indices > 65536 (or > 10K quads)
+		// closes the current batch (texture slot set), its draw is issued by DrawBatches.
 		void RenderBatch();
+		// uploads the vertices / indices of all the closed batches at once.
+		void UploadBatches();
+		// draws the batches [first, last) from their offsets, only the chunks inside cullBounds if not null.
+		void DrawBatches(size_t first, size_t last, const glm::vec4* cullBounds);
 		int AddTextureToBatch(Texture texture);
 		void ClearDrawQueue();
 		void ClearBatch();
 
+		// batches and draws the queued quads with the given camera matrices.
+		void RenderDrawQueue(const glm::mat4& view, const glm::mat4& projection);
+
+		// sorts, batches and uploads the queued quads, returns true if they use the depth pass.
+		bool PrepareDrawQueue();
+
+		// draws the prepared batches with the given camera matrices (can be called once per view).
+		void DrawPreparedQueue(const glm::mat4& view, const glm::mat4& projection, bool depthPass, const glm::vec4* cullBounds);
+
+		// batches and draws the queued quads in the given order, depths[quad] is written to the vertices (0 if null).
+		void BatchQuads(const std::vector<unsigned int>& order, const float* depths);
+
+		// true if the current target has a depth buffer and the shader reads the vertex depth.
+		bool CanUseDepthPass();
+
+		// window depth range {near, far} of the next depth pass on the current target, closer than the previous ones.
+		// clears the depth buffer at the first depth pass of the target in the frame, or when the depth range is used up.
+		glm::vec2 ReserveDepthRange(size_t quadCount);
+		// the depth buffer of the target was cleared: the next depth pass starts at the far plane again.
+		void ResetDepthBase(RenderTarget* target);
+
+		// true if the shader writes the clip distances of the clip rects (uClipRects).
+		bool CanUseClipDistances();
+
+		// index of the current clip rect in the table of the flush (added if needed), 0 if the draws are not clipped.
+		float GetClipIndex();
+
+		// dirty rect mode: stores the queued quads until the damaged region is known.
+		void DeferDirtyFlush();
+		void PresentDirtyRegions();
+
 		bool m_isInitialized = false;
 
 
@@ -174,9 +333,36 @@ namespace LittleEngine::Graphics
 		std::vector<unsigned int> m_indices;
 		std::vector<unsigned int> m_indicesBatch;
 		std::vector<Texture> m_textures;
+		std::vector<unsigned char> m_quadOpaque;		// 1 if the queued quad is opaque
 		std::array<Texture, defaults::MAX_TEXTURE_SLOTS> m_texturesBatch;
 		int m_bindedTextureCount = 0;
 
+		// range of m_indicesBatch drawn with a set of texture slots.
+		struct BatchRange
+		{
+			size_t indexStart;
+			size_t indexCount;
+			std::array<Texture, defaults::MAX_TEXTURE_SLOTS> textures;
+			int textureCount;
+			size_t firstChunk;
+			size_t chunkCount;
+		};
+		std::vector<BatchRange> m_batchRanges;
+		size_t m_batchIndexStart = 0;	// first index of the open batch
+		size_t m_opaqueBatchCount = 0;	// batches of the opaque pass, drawn before the translucent ones
+
+		// consecutive quads of a batch and their world bounds {min x, min y, max x, max y}, culled per view.
+		struct CullChunk
+		{
+			size_t indexStart;
+			size_t indexCount;
+			glm::vec4 bounds;
+		};
+		static constexpr size_t s_cullChunkQuads = 256;
+		std::vector<CullChunk> m_cullChunks;
+		size_t m_batchChunkStart = 0;	// first chunk of the open batch
+		size_t m_chunkQuadCount = 0;	// quads in the last chunk
+
 
 		// uniform texture sampler
 		const int m_samplers[16] = { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15 };
@@ -186,8 +372,78 @@ namespace LittleEngine::Graphics
 		unsigned int m_fullscreenVBO = 0;
 
 		Shader m_blitShader = {};
+		Shader m_sharpenShader = {};
 		Shader m_mergeLightSceneShader = {};
 
+		BlendMode m_blendMode = BlendMode::Alpha;
+
+		bool m_scissor = false;
+		glm::ivec4 m_scissorRect = { 0, 0, 0, 0 };	// {x, y, w, h} of SetScissorRect
+
+		// layers / opaque pass
+		float m_layer = 0.f;
+		bool m_opaque = false;
+		bool m_screenHasDepth = false;
+		int m_screenDepthBits = 0;
+		GLuint m_depthShader = 0;						// last shader checked for the vertex depth
+		bool m_depthShaderReadsDepth = false;
+		std::vector<std::pair<RenderTarget*, float>> m_depthBases;	// far end of the next depth pass of the targets (nullptr = screen) this frame
+		std::vector<unsigned int> m_drawOrder;			// queued quads sorted back-to-front
+		std::vector<unsigned int> m_opaqueOrder;		// opaque quads front-to-back
+		std::vector<unsigned int> m_translucentOrder;	// translucent quads back-to-front
+		std::vector<float> m_quadDepths;
+
+		// clip rects
+		std::vector<glm::vec4> m_clipStack;		// pushed rects {min x, min y, max x, max y}, intersected with their parent
+		std::vector<glm::vec4> m_clipRects;		// table of the queued quads, the first one is unclipped
+		int m_clipIndex = 0;					// index of the top of the stack in the table, -1 if not added yet
+		GLuint m_clipShader = 0;				// last shader checked for the clip rects
+		bool m_clipShaderWritesDistances = false;
+		bool m_clipWarned = false;				// the missing clip rects are only reported once
+
+		RenderTargetPool m_targetPool = {};
+		FrameCapture m_frameCapture = {};
+
+		// frame command capture
+		FrameTraceRecorder m_traceRecorder = {};
+		std::string m_tracePath;	// trace file of the next frame, empty if no capture is requested
+
+
+		// dirty rect mode
+
+		struct QuadRecord
+		{
+			glm::ivec4 bounds;	// {x0, y0, x1, y1} in pixels
+			size_t hash;		// hash of the quad vertices and texture
+		};
+
+		struct DeferredFlush
+		{
+			std::vector<Vertex> vertices;
+			std::vector<unsigned int> indices;
+			std::vector<Texture> textures;
+			std::vector<unsigned char> opaque;
+			std::vector<glm::vec4> clipRects;
+			glm::mat4 view;
+			glm::mat4 projection;
+
+			// state of the flush, restored when it is replayed
+			BlendMode blendMode;
+			GLuint shader;
+			bool scissor;
+			glm::ivec4 scissorRect;
+		};
+
+		bool m_dirtyRectMode = false;
+		bool m_fullRedraw = true;
+		Color m_dirtyClearColor = Colors::ClearColor;
+		glm::ivec4 m_lastDirtyRegion = { 0, 0, 0, 0 };
+		RenderTarget m_backBuffer = {};
+		std::vector<QuadRecord> m_quadRecords;			// quads flushed to the screen this frame
+		std::vector<QuadRecord> m_previousQuadRecords;	// quads flushed to the screen last frame
+		std::vector<DeferredFlush> m_deferredFlushes;	// reused between frames to avoid allocations
+		size_t m_deferredFlushCount = 0;
+
 	};
 
 }
\ No newline at end of file
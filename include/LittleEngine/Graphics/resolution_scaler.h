@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "LittleEngine/Graphics/render_target.h"
+
+
+namespace LittleEngine::Graphics
+{
+
+	struct ResolutionScalerConfig
+	{
+		float minScale = 0.5f;					// lowest allowed scale of the window size
+		float maxScale = 1.f;					// highest allowed scale of the window size
+		float step = 0.1f;						// scale change applied at each adjustment
+		float targetFrameTime = 1.f / 60.f;		// frame time (in seconds) the controller tries to hold
+		float downscaleThreshold = 1.1f;		// scale goes down when the frame time is above targetFrameTime * downscaleThreshold
+		float upscaleThreshold = 0.8f;			// scale goes up when the frame time is below targetFrameTime * upscaleThreshold
+		int cooldownFrames = 30;				// minimum number of frames between two adjustments
+		bool pixelated = false;					// if true, scaled targets use nearest filtering when upscaled
+	};
+
+
+	/**
+	 * Chooses the resolution the scene and light targets are rendered at.
+	 *
+	 * Feed it the work time of every frame (LittleEngine::GetFrameWorkTime), it lowers the scale in steps
+	 * when the frame takes longer than the target frame time, and raises it back when there is headroom.
+	 * The wall-clock GetFrameTime does not work: with vsync it never drops below the refresh period.
+	 *
+	 * The engine does not resize anything by itself, the game renders its scene and light targets
+	 * at the chosen size and upscales them to the screen with Renderer::BlitImage:
+	 *
+	 *	 scaler.Update(LittleEngine::GetFrameWorkTime());
+	 *	 scaler.ResizeTarget(sceneTarget, LittleEngine::GetWindowSize(), GL_RGB, true);
+	 *	 scaler.ResizeTarget(lightTarget, LittleEngine::GetWindowSize(), GL_RGB16F);
+	 *	 ... render the scene and the lights into the targets ...
+	 *	 renderer.SetRenderTarget(nullptr);
+	 *	 renderer.BlitImage(sceneTarget.GetTexture(), 0.5f);
+	 *
+	 * For pixel-art games, SetFixedResolution() gives a constant low internal resolution instead.
+	 */
+	class ResolutionScaler
+	{
+	public:
+
+		void Initialize(const ResolutionScalerConfig& config = {});
+
+		/**
+		 * Updates the controller with the duration of the last frame.
+		 *
+		 * @param: frameTime: work time of the last frame in seconds, without the vsync wait (GetFrameWorkTime).
+		 * @return: true if the scale changed (the targets have to be resized).
+		 */
+		bool Update(float frameTime);
+
+		// Sets the scale manually, clamped to [minScale, maxScale].
+		void SetScale(float scale);
+		float GetScale() const { return m_scale; }
+
+		/**
+		 * Renders at a constant resolution, whatever the window size (disables the controller).
+		 * Pass {0, 0} to go back to the dynamic scale.
+		 */
+		void SetFixedResolution(const glm::ivec2& size) { m_fixedResolution = size; }
+
+		// Returns the internal render size for the given window size.
+		glm::ivec2 GetRenderSize(const glm::ivec2& windowSize) const;
+
+		/**
+		 * Recreates the target if its size does not match the render size.
+		 * depthStencil adds a depth-stencil buffer (layers / opaque pass, stencil masks), a target which had one keeps it.
+		 *
+		 * @return: true if the target was (re)created.
+		 */
+		bool ResizeTarget(RenderTarget& target, const glm::ivec2& windowSize, GLenum internalFormat = GL_RGB, bool depthStencil = false) const;
+
+		const ResolutionScalerConfig& GetConfig() const { return m_config; }
+
+	private:
+		ResolutionScalerConfig m_config = {};
+
+		float m_scale = 1.f;
+		float m_averageFrameTime = 0.f;
+		int m_cooldown = 0;
+
+		glm::ivec2 m_fixedResolution = { 0, 0 };
+	};
+
+}
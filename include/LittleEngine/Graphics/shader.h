@@ -18,6 +18,10 @@ namespace LittleEngine::Graphics
 
         void Create(const std::string& vertex, const std::string& fragment, bool isPath = true);
 		void CreateDefault();
+
+        // creates a compute shader program from code (requires OpenGL 4.3, check GLAD_GL_VERSION_4_3).
+        void CreateCompute(const std::string& compute);
+
         void Cleanup();
 
         // creates the default shader
@@ -28,7 +32,9 @@ namespace LittleEngine::Graphics
         
         void SetBool(const std::string& name, bool value) const;
         void SetInt(const std::string& name, int value) const;
+        void SetUInt(const std::string& name, unsigned int value) const;
         void SetIntArray(const std::string& name, int size, const int* array) const;
+        void SetVec4Array(const std::string& name, int size, const glm::vec4* array) const;
         void SetFloat(const std::string& name, float value) const;
         void SetVec2(const std::string& name, const glm::vec2& value) const;
         void SetVec2(const std::string& name, float x, float y) const;
@@ -47,6 +53,7 @@ namespace LittleEngine::Graphics
 
         static GLuint CreateShaderFromFile(const std::string& vertexPath, const std::string& fragmentPath);
         static GLuint CreateShaderFromCode(const std::string& vertexCode, const std::string& fragmentCode);
+        static GLuint CreateComputeShaderFromCode(const std::string& computeCode);
 
         static GLuint s_defaultShader;
 
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "LittleEngine/Graphics/color.h"
+#include "LittleEngine/Graphics/renderer.h"
+#include "LittleEngine/Graphics/shader.h"
+#include "LittleEngine/Graphics/texture.h"
+
+
+namespace LittleEngine::Graphics
+{
+
+	// Per-instance sprite data, laid out as 3 vec4 to match the std430 storage buffer.
+	struct SpriteInstance
+	{
+		glm::vec4 rect = { 0, 0, 1, 1 };	// {x, y, w, h} in world units, (x, y) is the bottom left corner
+		glm::vec4 uv = { 0, 0, 1, 1 };		// {u_min, v_min, u_max, v_max}
+		Color color = Colors::White;
+	};
+
+	using SpriteInstanceId = unsigned int;
+
+
+	/**
+	 * Draws large amounts of persistent sprites sharing one texture (atlas) with instancing.
+	 *
+	 * Sprites are kept on the GPU between frames: Add / Update / Remove only upload the changed range.
+	 * Each Draw culls the sprites against the camera and draws the visible ones in submission order:
+	 * - OpenGL 4.3: a compute shader culls and compacts the visible sprites into a storage buffer,
+	 *   and writes the instance count of an indirect draw command (no CPU work per sprite).
+	 * - OpenGL 3.3: the sprites are culled on the CPU and the visible ones are uploaded as instance attributes.
+	 */
+	class SpriteInstanceRenderer
+	{
+	public:
+		SpriteInstanceRenderer() {};
+		~SpriteInstanceRenderer() { Shutdown(); }
+
+		SpriteInstanceRenderer(SpriteInstanceRenderer& other) = delete;
+		SpriteInstanceRenderer(SpriteInstanceRenderer&& other) = delete;
+		SpriteInstanceRenderer operator=(SpriteInstanceRenderer other) = delete;
+		SpriteInstanceRenderer operator=(SpriteInstanceRenderer& other) = delete;
+		SpriteInstanceRenderer operator=(SpriteInstanceRenderer&& other) = delete;
+
+		/**
+		 * @param: texture: texture (or atlas) used by all the sprites.
+		 * @param: capacity: initial number of sprites, the buffers grow if needed.
+		 * @param: forceCpuCulling: uses the OpenGL 3.3 path even if compute shaders are available.
+		 */
+		void Initialize(const Texture& texture, size_t capacity = 1024, bool forceCpuCulling = false);
+		void Shutdown();
+
+#pragma region Sprite management
+
+		SpriteInstanceId Add(const SpriteInstance& sprite);
+		void Update(SpriteInstanceId id, const SpriteInstance& sprite);
+
+		// Removes the sprite, its id can be returned by a later Add.
+		void Remove(SpriteInstanceId id);
+
+		// Removes all the sprites.
+		void Clear();
+
+		const SpriteInstance& Get(SpriteInstanceId id) const { return m_sprites[id]; }
+		size_t GetSpriteCount() const { return m_sprites.size() - m_freeIds.size(); }
+
+#pragma endregion
+
+		/**
+		 * Culls and draws the sprites to the current render target of the renderer,
+		 * with its camera and blend mode. The renderer queue is flushed first to keep the draw order.
+		 */
+		void Draw(Renderer* renderer);
+
+		bool IsGpuCulling() const { return m_gpuCulling; }
+
+		/**
+		 * Returns the number of sprites drawn by the last Draw.
+		 * With GPU culling this reads back the indirect command and stalls the pipeline: debug only.
+		 */
+		unsigned int GetVisibleCount() const;
+
+	private:
+
+		// grows the GPU buffers to hold at least the current sprites.
+		void Reserve(size_t capacity);
+
+		void MarkDirty(size_t index);
+		void UploadDirtyRange();
+
+		void CullAndDrawGpu(const glm::vec4& viewRect);
+		void CullAndDrawCpu(const glm::vec4& viewRect);
+
+		bool m_initialized = false;
+		bool m_gpuCulling = false;
+
+		Texture m_texture = {};
+
+		std::vector<SpriteInstance> m_sprites;
+		std::vector<SpriteInstanceId> m_freeIds;
+		std::vector<unsigned char> m_removed;		// 1 if the slot of m_sprites is in m_freeIds
+		size_t m_capacity = 0;
+
+		// range of m_sprites not uploaded yet [begin, end)
+		size_t m_dirtyBegin = 0;
+		size_t m_dirtyEnd = 0;
+
+		// unit quad
+		GLuint m_VAO = 0;
+		GLuint m_quadVBO = 0;
+		GLuint m_EBO = 0;
+
+		// GPU culling
+		GLuint m_spriteSSBO = 0;		// all the sprites
+		GLuint m_visibleSSBO = 0;		// indices of the visible sprites, compacted
+		GLuint m_groupSSBO = 0;			// visible count then offset of each work group
+		GLuint m_indirectBuffer = 0;	// DrawElementsIndirectCommand, also written by the compute shader
+		Shader m_countShader = {};
+		Shader m_scanShader = {};
+		Shader m_compactShader = {};
+
+		// CPU culling
+		GLuint m_instanceVBO = 0;
+		std::vector<SpriteInstance> m_visibleSprites;
+
+		Shader m_shader = {};
+
+		unsigned int m_lastVisibleCount = 0;
+	};
+
+}
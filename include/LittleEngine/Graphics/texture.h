@@ -24,6 +24,9 @@ namespace LittleEngine::Graphics
 		void Bind(const unsigned int sample = 0) const;
 		void Unbind(const unsigned int sample = 0) const;
 
+		// Sets nearest (pixelated) or linear filtering, used when the texture is scaled.
+		void SetPixelated(bool pixelated) const;
+
 		void Cleanup();
 
 		static Texture GetDefaultTexture();
@@ -22,6 +22,18 @@ namespace LittleEngine::Math
 
 	};
 
+	// Axis aligned bounding box
+	struct AABB
+	{
+		glm::vec2 min = { 0.f, 0.f };
+		glm::vec2 max = { 0.f, 0.f };
+
+		bool Intersects(const AABB& other) const
+		{
+			return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y;
+		}
+	};
+
 	/** Returns the orientation of the triplet (a, b, c).
 	 * 0 -> collinear
 	 * 1 -> clockwise
@@ -46,8 +58,23 @@ namespace LittleEngine::Math
 		void EnsureCounterClockwise();
 		float SignedArea() const;
 		bool IsSelfIntersecting() const;
+		bool IsConvex() const;
+
+		/**
+		 * Silhouette of a convex CCW polygon seen from an outside point, by binary search (O(log n)):
+		 * the edges facing the point (point on their right) go from vertex first to vertex last.
+		 * Returns false if the point is inside or on the polygon, or if the polygon is degenerate.
+		 */
+		bool FindTangents(const glm::vec2& point, size_t& first, size_t& last) const;
 
 		std::vector<Edge> GetEdges() const;
+		AABB GetBounds() const;
+
+		// Even-odd test, points on the boundary may be inside or outside.
+		bool Contains(const glm::vec2& point) const;
+
+		// Appends the triangles (3 vertices each) covering the polygon, by ear clipping (also for concave polygons).
+		void Triangulate(std::vector<glm::vec2>& triangles) const;
 	};
 
 } // namespace LittleEngine
\ No newline at end of file
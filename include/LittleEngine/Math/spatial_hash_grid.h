@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "LittleEngine/Math/geometry.h"
+
+
+namespace LittleEngine::Math
+{
+
+	/**
+	 * Uniform grid of square cells indexing values by their bounds, for the "what is near this area" queries.
+	 * Only the cells touched by a value exist (hashed), so the world has no size limit.
+	 * Insert, Remove and Update cost the number of cells touched by the bounds, values touching more than
+	 * 256 cells (huge or infinite bounds) are kept out of the cells and tested by every query.
+	 *
+	 *	 SpatialHashGrid<Enemy*> grid(64.f);
+	 *	 grid.Insert(enemy, enemy->GetBounds());
+	 *	 grid.Query({ center - radius, center + radius }, nearby);
+	 */
+	template<typename T>
+	class SpatialHashGrid
+	{
+	public:
+		explicit SpatialHashGrid(float cellSize = 128.f) : m_cellSize(cellSize > 0.f ? cellSize : 128.f) {}
+
+		// Changes the size of the cells, the values are inserted again.
+		void SetCellSize(float cellSize)
+		{
+			if (cellSize <= 0.f || cellSize == m_cellSize)
+				return;
+
+			m_cellSize = cellSize;
+			m_cells.clear();
+			m_largeItems.clear();
+			for (unsigned int i = 0; i < m_items.size(); i++)
+			{
+				if (m_items[i].used)
+					AddToCells(i);
+			}
+		}
+		float GetCellSize() const { return m_cellSize; }
+
+		// Adds the value, or moves it if it is already in the grid.
+		void Insert(const T& value, const AABB& bounds)
+		{
+			auto it = m_indices.find(value);
+			if (it != m_indices.end())
+			{
+				Update(value, bounds);
+				return;
+			}
+
+			unsigned int index;
+			if (!m_freeItems.empty())
+			{
+				index = m_freeItems.back();
+				m_freeItems.pop_back();
+			}
+			else
+			{
+				index = static_cast<unsigned int>(m_items.size());
+				m_items.emplace_back();
+			}
+
+			m_items[index] = { value, bounds, 0, true, false };
+			m_indices[value] = index;
+			AddToCells(index);
+		}
+
+		// Bounds the value was inserted with, nullptr if it is not in the grid.
+		const AABB* GetBounds(const T& value) const
+		{
+			auto it = m_indices.find(value);
+			return it != m_indices.end() ? &m_items[it->second].bounds : nullptr;
+		}
+
+		// Returns false if the value is not in the grid.
+		bool Remove(const T& value)
+		{
+			auto it = m_indices.find(value);
+			if (it == m_indices.end())
+				return false;
+
+			unsigned int index = it->second;
+			RemoveFromCells(index);
+			m_items[index].used = false;
+			m_freeItems.push_back(index);
+			m_indices.erase(it);
+			return true;
+		}
+
+		// Moves the value to its new bounds, only touches the cells if they changed.
+		bool Update(const T& value, const AABB& bounds)
+		{
+			auto it = m_indices.find(value);
+			if (it == m_indices.end())
+				return false;
+
+			Item& item = m_items[it->second];
+			glm::ivec4 oldCells = GetCellRange(item.bounds);
+			item.bounds = bounds;
+			if (GetCellRange(bounds) != oldCells)
+			{
+				RemoveFromCells(it->second, oldCells);
+				AddToCells(it->second);
+			}
+			return true;
+		}
+
+		void Clear()
+		{
+			m_cells.clear();
+			m_largeItems.clear();
+			m_items.clear();
+			m_freeItems.clear();
+			m_indices.clear();
+		}
+
+		size_t Size() const { return m_indices.size(); }
+
+		/**
+		 * Appends the values whose bounds intersect the area, each value once, in no particular order.
+		 */
+		void Query(const AABB& area, std::vector<T>& values)
+		{
+			glm::ivec4 range = GetCellRange(area);
+			if (GetCellCount(range) > static_cast<int64_t>(m_indices.size()))
+			{
+				// more cells than values (e.g. an area covering the whole world): testing every value is cheaper.
+				for (const Item& item : m_items)
+				{
+					if (item.used && item.bounds.Intersects(area))
+						values.push_back(item.value);
+				}
+				return;
+			}
+
+			// the values spanning several cells are only added once (stamp of the query)
+			if (++m_queryStamp == 0)
+			{
+				for (Item& item : m_items)
+					item.stamp = 0;
+				m_queryStamp = 1;
+			}
+
+			for (int y = range.y; y <= range.w; y++)
+			{
+				for (int x = range.x; x <= range.z; x++)
+				{
+					auto cell = m_cells.find(GetKey(x, y));
+					if (cell == m_cells.end())
+						continue;
+
+					for (unsigned int index : cell->second)
+					{
+						Item& item = m_items[index];
+						if (item.stamp == m_queryStamp || !item.bounds.Intersects(area))
+							continue;
+
+						item.stamp = m_queryStamp;
+						values.push_back(item.value);
+					}
+				}
+			}
+
+			for (unsigned int index : m_largeItems)
+			{
+				if (m_items[index].bounds.Intersects(area))
+					values.push_back(m_items[index].value);
+			}
+		}
+
+	private:
+
+		struct Item
+		{
+			T value = {};
+			AABB bounds = {};
+			unsigned int stamp = 0;	// last query which returned it
+			bool used = false;
+			bool large = false;		// in m_largeItems instead of the cells
+		};
+
+		static constexpr int s_maxCell = 1 << 28;			// cell coordinates are clamped, the ranges of huge bounds stay in int
+		static constexpr int64_t s_maxItemCells = 256;		// values touching more cells go to m_largeItems
+
+		static uint64_t GetKey(int x, int y)
+		{
+			return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+		}
+
+		// cell of the coordinate, clamped before the cast (casting an out of range float is undefined, NaN gives -s_maxCell).
+		int GetCell(float coordinate) const
+		{
+			float cell = std::floor(coordinate / m_cellSize);
+			if (!(cell > static_cast<float>(-s_maxCell)))
+				return -s_maxCell;
+			if (cell > static_cast<float>(s_maxCell))
+				return s_maxCell;
+			return static_cast<int>(cell);
+		}
+
+		// cells {x0, y0, x1, y1} touched by the bounds (inclusive)
+		glm::ivec4 GetCellRange(const AABB& bounds) const
+		{
+			return { GetCell(bounds.min.x), GetCell(bounds.min.y), GetCell(bounds.max.x), GetCell(bounds.max.y) };
+		}
+
+		static int64_t GetCellCount(const glm::ivec4& range)
+		{
+			if (range.z < range.x || range.w < range.y)
+				return 0;
+			return (static_cast<int64_t>(range.z) - range.x + 1) * (static_cast<int64_t>(range.w) - range.y + 1);
+		}
+
+		void AddToCells(unsigned int index)
+		{
+			Item& item = m_items[index];
+			glm::ivec4 range = GetCellRange(item.bounds);
+			item.large = GetCellCount(range) > s_maxItemCells;
+			if (item.large)
+			{
+				m_largeItems.push_back(index);
+				return;
+			}
+
+			for (int y = range.y; y <= range.w; y++)
+				for (int x = range.x; x <= range.z; x++)
+					m_cells[GetKey(x, y)].push_back(index);
+		}
+
+		void RemoveFromCells(unsigned int index)
+		{
+			RemoveFromCells(index, GetCellRange(m_items[index].bounds));
+		}
+
+		void RemoveFromCells(unsigned int index, const glm::ivec4& range)
+		{
+			if (m_items[index].large)
+			{
+				auto it = std::find(m_largeItems.begin(), m_largeItems.end(), index);
+				if (it != m_largeItems.end())
+				{
+					*it = m_largeItems.back();	// order does not matter
+					m_largeItems.pop_back();
+				}
+				m_items[index].large = false;
+				return;
+			}
+
+			for (int y = range.y; y <= range.w; y++)
+			{
+				for (int x = range.x; x <= range.z; x++)
+				{
+					auto cell = m_cells.find(GetKey(x, y));
+					if (cell == m_cells.end())
+						continue;
+
+					std::vector<unsigned int>& indices = cell->second;
+					for (size_t i = 0; i < indices.size(); i++)
+					{
+						if (indices[i] == index)
+						{
+							indices[i] = indices.back();	// order does not matter
+							indices.pop_back();
+							break;
+						}
+					}
+					if (indices.empty())
+						m_cells.erase(cell);
+				}
+			}
+		}
+
+		float m_cellSize = 128.f;
+		unsigned int m_queryStamp = 0;
+
+		std::unordered_map<uint64_t, std::vector<unsigned int>> m_cells;	// cell -> items touching it
+		std::vector<Item> m_items;
+		std::vector<unsigned int> m_largeItems;								// items touching more than s_maxItemCells cells
+		std::vector<unsigned int> m_freeItems;
+		std::unordered_map<T, unsigned int> m_indices;						// value -> item
+	};
+
+}
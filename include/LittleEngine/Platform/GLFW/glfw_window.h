@@ -21,6 +21,8 @@ namespace LittleEngine::Platform
 
 
 		void OnUpdate() override;
+		void WaitEvents(double timeout) override;
+		void PostEmptyEvent() override;
 
 
 		// =======
@@ -38,6 +40,7 @@ namespace LittleEngine::Platform
 		bool ShouldClose() const override;
 		void* GetNativeWindowHandle() override { return static_cast<void*>(m_window); } // returns the GLFWwindow*
 		void* GetNativeContext() override { return nullptr; } //not applicable for GLFW, returns nullptr
+		unsigned int GetEventCount() const override { return m_state.eventCount; }
 
 		// =========
 		// Callbacks
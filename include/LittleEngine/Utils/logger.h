@@ -4,6 +4,7 @@
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 
 
 namespace LittleEngine::Utils
@@ -18,6 +19,7 @@ namespace LittleEngine::Utils
 		Critical
 	};
 
+	// Can be called from any thread, the messages are written one at a time.
 	class Logger
 	{
 	public:
@@ -36,6 +38,7 @@ namespace LittleEngine::Utils
 	private:
 		static bool s_logToFile;
 		static std::ofstream s_logFileStream;
+		static std::mutex s_mutex;		// guards the console and the log file
 
 		static void Log(LogLevel level, const std::string& message);
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace LittleEngine::Utils
+{
+
+	/**
+	 * Fixed set of worker threads running one ParallelFor at a time.
+	 * The calling thread also works, so a pool with 0 threads runs the tasks inline.
+	 *
+	 *	 pool.Initialize(std::thread::hardware_concurrency() - 1);
+	 *	 pool.ParallelFor(items.size(), [&](size_t begin, size_t end) { for (size_t i = begin; i < end; i++) Process(items[i]); });
+	 */
+	class ThreadPool
+	{
+	public:
+		ThreadPool() {};
+		~ThreadPool() { Shutdown(); }
+
+		ThreadPool(ThreadPool& other) = delete;
+		ThreadPool(ThreadPool&& other) = delete;
+		ThreadPool operator=(ThreadPool other) = delete;
+		ThreadPool operator=(ThreadPool& other) = delete;
+		ThreadPool operator=(ThreadPool&& other) = delete;
+
+		void Initialize(unsigned int threadCount);
+		void Shutdown();
+
+		unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+		/**
+		 * Calls task(begin, end) on consecutive ranges covering [0, count), from the workers and the
+		 * calling thread, and returns when all of them are done. Not reentrant (no ParallelFor in a task).
+		 *
+		 * @param: minRange: smallest range given to a thread, raise it for tiny tasks.
+		 */
+		void ParallelFor(size_t count, const std::function<void(size_t, size_t)>& task, size_t minRange = 1);
+
+	private:
+
+		void WorkerLoop();
+
+		// runs the ranges of the current job until there is none left.
+		void RunRanges();
+
+		std::vector<std::thread> m_threads;
+
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		bool m_stop = false;
+		unsigned int m_generation = 0;		// incremented for each job
+		unsigned int m_activeWorkers = 0;
+
+		// current job, only written when no worker is active
+		const std::function<void(size_t, size_t)>* m_task = nullptr;
+		size_t m_count = 0;
+		size_t m_rangeSize = 1;
+		size_t m_rangeCount = 0;
+		std::atomic<size_t> m_nextRange{ 0 };
+	};
+
+}
@@ -11,6 +11,7 @@ namespace LittleEngine
 		const float viewHeight = 18.f;		// the screen shows 32 tiles / meters in horizontal axis
 		const int QuadCount = 1000;
 		const int MAX_TEXTURE_SLOTS = 16;
+		const int MAX_CLIP_RECTS = 32;		// clip rects per flush (Renderer::PushClipRect, uClipRects of the default shader), the first one is unclipped
 		const int maxFileCount = 1000;		// used to detect next free filename (for screenshot32.png) caps at 1000
 	}
 
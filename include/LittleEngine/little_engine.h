@@ -28,11 +28,17 @@
 #include "LittleEngine/Graphics/shader.h"
 #include "LittleEngine/Graphics/texture.h"
 #include "LittleEngine/Graphics/tilemap_renderer.h"
+#include "LittleEngine/Graphics/sprite_instance_renderer.h"
 #include "LittleEngine/Graphics/lighting.h"
 #include "LittleEngine/Input/input.h"
 #include "LittleEngine/Audio/audio.h"
 #include "LittleEngine/Audio/sound.h"
 #include "LittleEngine/Graphics/render_target.h"
+#include "LittleEngine/Graphics/render_graph.h"
+#include "LittleEngine/Graphics/resolution_scaler.h"
+#include "LittleEngine/Graphics/frame_capture.h"
+#include "LittleEngine/Graphics/post_process_stack.h"
+#include "LittleEngine/Graphics/frame_trace.h"
 #include "LittleEngine/UI/ui_system.h"
 
 #include "LittleEngine/Math/geometry.h"
@@ -144,6 +150,8 @@ namespace LittleEngine
 		bool maximized = false; // if true, the window will be maximized on startup (only works for resizable windowed mode)
 		bool vsync = true;
 		std::string iconPath = ""; // path to the application icon, can be empty
+		bool idleRendering = false; // if true, the loop sleeps until an event arrives or a redraw is requested (for editors / menu-driven games)
+		float idleTimeout = 0.5f; // maximum time (in seconds) the loop sleeps in idle rendering mode, <= 0 sleeps until the next event
 	};
 
 
@@ -163,10 +171,32 @@ namespace LittleEngine
 
 	float GetFPS();
 
+	// Returns the duration of the last frame in seconds.
+	float GetFrameTime();
+
+	/**
+	 * Returns the time spent in the update and render of the last frame in seconds, without the
+	 * vsync wait of the buffer swap and the sleep of the idle rendering mode (see ResolutionScaler).
+	 * GPU work still queued when the frame is submitted is not included.
+	 */
+	float GetFrameWorkTime();
+
 	Window* GetWindow();
 
 	void SetVsync(bool b);
 
+	/**
+	 * Idle rendering mode: when enabled, frames are only produced when an input / window event
+	 * arrived, a redraw was requested, or an animation is running.
+	 */
+	void SetIdleRendering(bool enabled, float timeout = 0.5f);
+
+	// Requests a new frame in idle rendering mode, can be called from any thread.
+	void RequestRedraw();
+
+	// While animating is true, frames are produced continuously even in idle rendering mode.
+	void SetAnimating(bool animating);
+
 
 
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "LittleEngine/Utils/logger.h"
 
+#include <limits>
+
 namespace LittleEngine::Graphics
 {
 
@@ -76,6 +78,23 @@ namespace LittleEngine::Graphics
 		
 	}
 
+	glm::vec4 Camera::GetVisibleBounds() const
+	{
+		glm::mat4 invViewProj = glm::inverse(GetProjectionMatrix() * GetViewMatrix());
+
+		glm::vec2 min{ std::numeric_limits<float>::max() };
+		glm::vec2 max{ std::numeric_limits<float>::lowest() };
+		const glm::vec2 corners[4] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+		for (const auto& corner : corners)
+		{
+			glm::vec4 world = invViewProj * glm::vec4(corner, 0.f, 1.f);
+			glm::vec2 pos = glm::vec2(world) / world.w;
+			min = glm::min(min, pos);
+			max = glm::max(max, pos);
+		}
+		return { min, max };
+	}
+
 
 	glm::mat4 Camera::GetProjectionMatrix() const
 	{
@@ -0,0 +1,422 @@
+#include "LittleEngine/Graphics/frame_capture.h"
+#include "LittleEngine/Graphics/bitmap_helper.h"
+
+#include "LittleEngine/Utils/logger.h"
+#include "LittleEngine/Utils/file_system.h"
+
+#include <stb_image/stb_image_write.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+
+namespace LittleEngine::Graphics
+{
+
+#pragma region Initialization
+
+	void FrameCapture::Initialize(int bufferCount, size_t maxQueuedFrames)
+	{
+		if (m_initialized)
+		{
+			Utils::Logger::Warning("FrameCapture::Initialize : already initialized");
+			return;
+		}
+
+		m_readbacks.resize(std::max(bufferCount, 1));
+		for (Readback& readback : m_readbacks)
+		{
+			glGenBuffers(1, &readback.pbo);	// storage is allocated at the first capture
+		}
+
+		m_maxQueuedFrames = std::max<size_t>(maxQueuedFrames, 1);
+		m_stopWriter = false;
+		m_writer = std::thread(&FrameCapture::WriterLoop, this);
+
+		m_initialized = true;
+	}
+
+	void FrameCapture::Shutdown()
+	{
+		if (!m_initialized)
+			return;
+
+		if (m_recording)
+			StopRecording();
+
+		// finish the readbacks still on the GPU
+		std::vector<Readback*> pending;
+		for (Readback& readback : m_readbacks)
+		{
+			if (readback.fence)
+				pending.push_back(&readback);
+		}
+		std::sort(pending.begin(), pending.end(), [](const Readback* a, const Readback* b) { return a->sequence < b->sequence; });
+		for (Readback* readback : pending)
+		{
+			CompleteReadback(*readback, true);
+		}
+
+		// let the writer thread write everything queued
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopWriter = true;
+		}
+		m_condition.notify_all();
+		if (m_writer.joinable())
+			m_writer.join();
+
+		for (Readback& readback : m_readbacks)
+		{
+			glDeleteBuffers(1, &readback.pbo);
+		}
+		m_readbacks.clear();
+
+		m_initialized = false;
+	}
+
+#pragma endregion
+
+	void FrameCapture::CaptureScreenshot(const glm::ivec2& size, bool isScreen, const std::string& name)
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("FrameCapture::CaptureScreenshot : not initialized");
+			return;
+		}
+
+		Job job;
+		job.type = JobType::Screenshot;
+		job.path = name;
+		job.size = size;
+		StartReadback(std::move(job), isScreen);
+	}
+
+#pragma region Recording
+
+	void FrameCapture::StartRecording(const std::string& directory, CaptureFormat format, int frameInterval)
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("FrameCapture::StartRecording : not initialized");
+			return;
+		}
+
+		if (m_recording)
+			StopRecording();
+
+		Utils::FileSystem::CreateDirectories(directory);
+
+		m_recordDirectory = directory;
+		m_recordFormat = format;
+		m_frameInterval = std::max(frameInterval, 1);
+		m_frameCounter = 0;
+		m_recordedFrames = 0;
+		m_droppedFrames = 0;
+		m_recording = true;
+	}
+
+	void FrameCapture::StopRecording()
+	{
+		if (!m_recording)
+			return;
+
+		m_recording = false;
+
+		if (m_recordFormat != CaptureFormat::Raw)
+			return;
+
+		// the frames still on the GPU have to reach the stream before it is closed.
+		std::vector<Readback*> pending;
+		for (Readback& readback : m_readbacks)
+		{
+			if (readback.fence && readback.job.type == JobType::RawFrame)
+				pending.push_back(&readback);
+		}
+		std::sort(pending.begin(), pending.end(), [](const Readback* a, const Readback* b) { return a->sequence < b->sequence; });
+		for (Readback* readback : pending)
+		{
+			CompleteReadback(*readback, true);
+		}
+
+		Job job;
+		job.type = JobType::EndStream;
+		QueueJob(std::move(job));
+	}
+
+	void FrameCapture::CaptureFrame(const glm::ivec2& size, bool isScreen)
+	{
+		if (!m_recording)
+			return;
+
+		if (m_frameCounter++ % m_frameInterval != 0)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_jobs.size() >= m_maxQueuedFrames)
+			{
+				// the writer is behind: skip the frame instead of growing the queue (or stalling).
+				m_droppedFrames++;
+				return;
+			}
+		}
+
+		Job job;
+		job.size = size;
+		if (m_recordFormat == CaptureFormat::Png)
+		{
+			std::ostringstream ss;
+			ss << m_recordDirectory << "/frame_" << std::setw(6) << std::setfill('0') << m_recordedFrames << ".png";
+			job.type = JobType::PngFrame;
+			job.path = ss.str();
+		}
+		else
+		{
+			job.type = JobType::RawFrame;
+			job.path = m_recordDirectory;
+		}
+		m_recordedFrames++;
+
+		StartReadback(std::move(job), isScreen);
+	}
+
+#pragma endregion
+
+	void FrameCapture::Update()
+	{
+		if (!m_initialized)
+			return;
+
+		// hand the finished readbacks over in submission order, stops at the first one still in flight.
+		while (true)
+		{
+			Readback* oldest = nullptr;
+			for (Readback& readback : m_readbacks)
+			{
+				if (readback.fence && (!oldest || readback.sequence < oldest->sequence))
+					oldest = &readback;
+			}
+
+			if (!oldest || !CompleteReadback(*oldest, false))
+				break;
+		}
+	}
+
+	size_t FrameCapture::GetPendingCount()
+	{
+		size_t count = 0;
+		for (const Readback& readback : m_readbacks)
+		{
+			if (readback.fence)
+				count++;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (const Job& job : m_jobs)
+		{
+			if (job.type != JobType::EndStream)
+				count++;
+		}
+		return count + (m_writing ? 1 : 0);
+	}
+
+	void FrameCapture::StartReadback(Job&& job, bool isScreen)
+	{
+		if (job.size.x <= 0 || job.size.y <= 0)
+		{
+			Utils::Logger::Warning("FrameCapture::StartReadback : invalid size");
+			return;
+		}
+
+		Readback* slot = nullptr;
+		Readback* oldest = nullptr;
+		for (Readback& readback : m_readbacks)
+		{
+			if (!readback.fence)
+			{
+				slot = &readback;
+				break;
+			}
+			if (!oldest || readback.sequence < oldest->sequence)
+				oldest = &readback;
+		}
+
+		if (!slot)
+		{
+			// every buffer is in flight: wait for the oldest one (only happens when capturing several times per frame).
+			CompleteReadback(*oldest, true);
+			slot = oldest;
+		}
+
+		size_t bytes = (size_t)job.size.x * job.size.y * 4;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+		if (slot->capacity < bytes)
+		{
+			glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+			slot->capacity = bytes;
+		}
+
+		glReadBuffer(isScreen ? GL_BACK : GL_COLOR_ATTACHMENT0);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, job.size.x, job.size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);	// asynchronous, writes to the pbo
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot->sequence = m_sequence++;
+		slot->job = std::move(job);
+	}
+
+	bool FrameCapture::CompleteReadback(Readback& readback, bool wait)
+	{
+		if (!readback.fence)
+			return false;
+
+		const GLuint64 timeout = wait ? 1000000000ull : 0;	// 1 second
+		GLenum status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		if (status == GL_TIMEOUT_EXPIRED && !wait)
+			return false;
+
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+
+		if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED)
+		{
+			Utils::Logger::Error("FrameCapture::CompleteReadback : readback failed, frame dropped");
+			readback.job = {};
+			return true;
+		}
+
+		Job& job = readback.job;
+		size_t bytes = (size_t)job.size.x * job.size.y * 4;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+		void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+		if (data)
+		{
+			job.pixels.resize(bytes);
+			std::memcpy(job.pixels.data(), data, bytes);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		if (!data)
+		{
+			Utils::Logger::Error("FrameCapture::CompleteReadback : failed to map the pixel buffer, frame dropped");
+			job = {};
+			return true;
+		}
+
+		QueueJob(std::move(job));
+		job = {};
+		return true;
+	}
+
+#pragma region Writer thread
+
+	void FrameCapture::QueueJob(Job&& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(std::move(job));
+		}
+		m_condition.notify_one();
+	}
+
+	void FrameCapture::WriterLoop()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]() { return m_stopWriter || !m_jobs.empty(); });
+
+				if (m_jobs.empty())	// stopped and nothing left to write
+					break;
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+				m_writing = true;
+			}
+
+			WriteJob(job);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_writing = false;
+		}
+
+		if (m_rawStream.is_open())
+			m_rawStream.close();
+	}
+
+	void FrameCapture::WriteJob(Job& job)
+	{
+		if (job.type == JobType::EndStream)
+		{
+			if (m_rawStream.is_open())
+				m_rawStream.close();
+			m_rawStreamPath.clear();
+			return;
+		}
+
+		// opengl has bottom left as origin, images have top left.
+		FlipBitmapVertically(job.pixels.data(), job.size.x, job.size.y, 4);
+
+		switch (job.type)
+		{
+		case JobType::Screenshot:
+		{
+			// resolved here so that queued screenshots don't get the same name.
+			std::string path = Utils::FileSystem::GetNextFreeFilepath("screenshots", job.path, ".png");
+			if (!stbi_write_png(path.c_str(), job.size.x, job.size.y, 4, job.pixels.data(), job.size.x * 4))
+				Utils::Logger::Error("FrameCapture::WriteJob : failed to write " + path);
+			break;
+		}
+		case JobType::PngFrame:
+			if (!stbi_write_png(job.path.c_str(), job.size.x, job.size.y, 4, job.pixels.data(), job.size.x * 4))
+				Utils::Logger::Error("FrameCapture::WriteJob : failed to write " + job.path);
+			break;
+		case JobType::RawFrame:
+		{
+			if (m_rawStreamPath != job.path)
+			{
+				if (m_rawStream.is_open())
+					m_rawStream.close();
+
+				m_rawStream.open(job.path + "/capture.rgba", std::ios::binary | std::ios::trunc);
+				m_rawStreamPath = job.path;
+				m_rawStreamSize = job.size;
+
+				std::ostringstream ss;
+				ss << "format rgba8\nwidth " << job.size.x << "\nheight " << job.size.y << "\n";
+				Utils::FileSystem::WriteTextFile(job.path + "/capture.txt", ss.str());
+			}
+
+			if (!m_rawStream.is_open())
+			{
+				Utils::Logger::Error("FrameCapture::WriteJob : failed to open " + job.path + "/capture.rgba");
+				break;
+			}
+
+			if (job.size != m_rawStreamSize)
+			{
+				Utils::Logger::Warning("FrameCapture::WriteJob : frame size changed during a raw capture, frame skipped");
+				break;
+			}
+
+			m_rawStream.write(reinterpret_cast<const char*>(job.pixels.data()), job.pixels.size());
+			m_rawStream.flush();
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,722 @@
+#include "LittleEngine/Graphics/frame_trace.h"
+#include "LittleEngine/Graphics/renderer.h"
+
+#include "LittleEngine/Utils/logger.h"
+#include "LittleEngine/Utils/file_system.h"
+
+#include <cstring>
+
+
+namespace LittleEngine::Graphics
+{
+
+	// file layout: magic, version, then each table as a count followed by its elements.
+	static const char s_traceMagic[4] = { 'L', 'E', 'F', 'T' };
+	static const unsigned int s_traceVersion = 3;
+
+
+#pragma region Serialization
+
+	template<typename T>
+	static void WriteValue(std::vector<unsigned char>& data, const T& value)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	// reads values from a buffer, stops (and stays invalid) at the first read past the end.
+	struct TraceReader
+	{
+		const std::vector<unsigned char>& data;
+		size_t offset = 0;
+		bool valid = true;
+
+		template<typename T>
+		T Read()
+		{
+			T value = {};
+			if (!valid || offset + sizeof(T) > data.size())
+			{
+				valid = false;
+				return value;
+			}
+			std::memcpy(&value, data.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		// reads a count, checking that count elements of elementSize bytes can fit in the rest of the buffer.
+		unsigned int ReadCount(size_t elementSize)
+		{
+			unsigned int count = Read<unsigned int>();
+			if (valid && (size_t)count * elementSize > data.size() - offset)
+				valid = false;
+			return valid ? count : 0;
+		}
+	};
+
+	bool FrameTrace::Save(const std::string& path) const
+	{
+		std::vector<unsigned char> data;
+
+		data.insert(data.end(), s_traceMagic, s_traceMagic + 4);
+		WriteValue(data, s_traceVersion);
+		WriteValue(data, screenSize);
+
+		WriteValue(data, (unsigned int)textures.size());
+		for (const TextureData& texture : textures)
+		{
+			WriteValue(data, texture.width);
+			WriteValue(data, texture.height);
+			WriteValue(data, texture.channelCount);
+			WriteValue(data, (unsigned char)texture.pixelated);
+			WriteValue(data, texture.renderTarget);
+			WriteValue(data, (unsigned int)texture.pixels.size());
+			data.insert(data.end(), texture.pixels.begin(), texture.pixels.end());
+		}
+
+		WriteValue(data, (unsigned int)targets.size());
+		for (const TargetData& target : targets)
+		{
+			WriteValue(data, target.size);
+			WriteValue(data, target.format);
+			WriteValue(data, (unsigned char)target.depthStencil);
+		}
+
+		WriteValue(data, (unsigned int)cameras.size());
+		for (const Camera& camera : cameras)
+		{
+			WriteValue(data, camera.position);
+			WriteValue(data, camera.rotation);
+			WriteValue(data, camera.zoom);
+			WriteValue(data, camera.viewportSize);
+			WriteValue(data, (unsigned char)camera.centered);
+		}
+
+		WriteValue(data, (unsigned int)quads.size());
+		for (const Quad& quad : quads)
+		{
+			for (const QuadVertex& vertex : quad.vertices)
+				WriteValue(data, vertex);
+			WriteValue(data, quad.texture);
+			WriteValue(data, quad.layer);
+			WriteValue(data, (unsigned char)quad.opaque);
+			WriteValue(data, (unsigned char)quad.clipped);
+			WriteValue(data, quad.clipRect);
+		}
+
+		WriteValue(data, (unsigned int)views.size());
+		for (const View& view : views)
+		{
+			WriteValue(data, view.camera);
+			WriteValue(data, view.viewport);
+			WriteValue(data, (unsigned char)view.cull);
+		}
+
+		WriteValue(data, (unsigned int)commands.size());
+		for (const Command& command : commands)
+		{
+			WriteValue(data, command.type);
+			switch (command.type)
+			{
+			case TraceCommandType::SetRenderTarget:
+			case TraceCommandType::SetBlendMode:
+				WriteValue(data, command.a);
+				break;
+			case TraceCommandType::Clear:
+			case TraceCommandType::SetScissor:
+				WriteValue(data, command.data);
+				break;
+			case TraceCommandType::Flush:
+				WriteValue(data, command.a);
+				WriteValue(data, command.firstQuad);
+				WriteValue(data, command.quadCount);
+				break;
+			case TraceCommandType::FlushViews:
+				WriteValue(data, command.a);
+				WriteValue(data, command.b);
+				WriteValue(data, command.firstQuad);
+				WriteValue(data, command.quadCount);
+				break;
+			case TraceCommandType::Blit:
+				WriteValue(data, command.a);
+				WriteValue(data, command.value);
+				break;
+			case TraceCommandType::MergeLightScene:
+				WriteValue(data, command.a);
+				WriteValue(data, command.b);
+				break;
+			default:
+				break;
+			}
+		}
+
+		if (!Utils::FileSystem::WriteBinaryFile(path, data))
+		{
+			Utils::Logger::Error("FrameTrace::Save : failed to write " + path);
+			return false;
+		}
+		return true;
+	}
+
+	bool FrameTrace::Load(const std::string& path)
+	{
+		Clear();
+
+		std::vector<unsigned char> data;
+		if (!Utils::FileSystem::ReadBinaryFile(path, &data))
+		{
+			Utils::Logger::Error("FrameTrace::Load : failed to read " + path);
+			return false;
+		}
+
+		if (data.size() < 8 || std::memcmp(data.data(), s_traceMagic, 4) != 0)
+		{
+			Utils::Logger::Error("FrameTrace::Load : " + path + " is not a frame trace");
+			return false;
+		}
+
+		TraceReader reader{ data, 4 };
+		unsigned int version = reader.Read<unsigned int>();
+		if (version != s_traceVersion)
+		{
+			Utils::Logger::Error("FrameTrace::Load : unsupported trace version " + std::to_string(version));
+			return false;
+		}
+		screenSize = reader.Read<glm::ivec2>();
+
+		textures.resize(reader.ReadCount(21));
+		for (TextureData& texture : textures)
+		{
+			texture.width = reader.Read<int>();
+			texture.height = reader.Read<int>();
+			texture.channelCount = reader.Read<int>();
+			texture.pixelated = reader.Read<unsigned char>() != 0;
+			texture.renderTarget = reader.Read<int>();
+			texture.pixels.resize(reader.ReadCount(1));
+			if (reader.valid && !texture.pixels.empty())
+			{
+				std::memcpy(texture.pixels.data(), data.data() + reader.offset, texture.pixels.size());
+				reader.offset += texture.pixels.size();
+			}
+		}
+
+		targets.resize(reader.ReadCount(13));
+		for (TargetData& target : targets)
+		{
+			target.size = reader.Read<glm::ivec2>();
+			target.format = reader.Read<GLenum>();
+			target.depthStencil = reader.Read<unsigned char>() != 0;
+		}
+
+		cameras.resize(reader.ReadCount(25));
+		for (Camera& camera : cameras)
+		{
+			camera.position = reader.Read<glm::vec2>();
+			camera.rotation = reader.Read<float>();
+			camera.zoom = reader.Read<float>();
+			camera.viewportSize = reader.Read<glm::ivec2>();
+			camera.centered = reader.Read<unsigned char>() != 0;
+		}
+
+		quads.resize(reader.ReadCount(sizeof(QuadVertex) * 4 + 26));
+		for (Quad& quad : quads)
+		{
+			for (QuadVertex& vertex : quad.vertices)
+				vertex = reader.Read<QuadVertex>();
+			quad.texture = reader.Read<unsigned int>();
+			quad.layer = reader.Read<float>();
+			quad.opaque = reader.Read<unsigned char>() != 0;
+			quad.clipped = reader.Read<unsigned char>() != 0;
+			quad.clipRect = reader.Read<glm::vec4>();
+		}
+
+		views.resize(reader.ReadCount(21));
+		for (View& view : views)
+		{
+			view.camera = reader.Read<unsigned int>();
+			view.viewport = reader.Read<glm::ivec4>();
+			view.cull = reader.Read<unsigned char>() != 0;
+		}
+
+		commands.resize(reader.ReadCount(1));
+		for (Command& command : commands)
+		{
+			command.type = reader.Read<TraceCommandType>();
+			switch (command.type)
+			{
+			case TraceCommandType::SetRenderTarget:
+			case TraceCommandType::SetBlendMode:
+				command.a = reader.Read<int>();
+				break;
+			case TraceCommandType::Clear:
+			case TraceCommandType::SetScissor:
+				command.data = reader.Read<glm::vec4>();
+				break;
+			case TraceCommandType::Flush:
+				command.a = reader.Read<int>();
+				command.firstQuad = reader.Read<unsigned int>();
+				command.quadCount = reader.Read<unsigned int>();
+				break;
+			case TraceCommandType::FlushViews:
+				command.a = reader.Read<int>();
+				command.b = reader.Read<int>();
+				command.firstQuad = reader.Read<unsigned int>();
+				command.quadCount = reader.Read<unsigned int>();
+				break;
+			case TraceCommandType::Blit:
+				command.a = reader.Read<int>();
+				command.value = reader.Read<float>();
+				break;
+			case TraceCommandType::MergeLightScene:
+				command.a = reader.Read<int>();
+				command.b = reader.Read<int>();
+				break;
+			case TraceCommandType::DisableScissor:
+				break;
+			default:
+				reader.valid = false;
+				break;
+			}
+		}
+
+		if (!reader.valid || !Validate())
+		{
+			Utils::Logger::Error("FrameTrace::Load : " + path + " is truncated or corrupted");
+			Clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool FrameTrace::Validate() const
+	{
+		for (const TextureData& texture : textures)
+		{
+			if (texture.renderTarget >= (int)targets.size())
+				return false;
+			if (texture.renderTarget < 0 && texture.pixels.size() != (size_t)texture.width * texture.height * texture.channelCount)
+				return false;
+		}
+
+		for (const Quad& quad : quads)
+		{
+			if (quad.texture >= textures.size())
+				return false;
+		}
+
+		for (const View& view : views)
+		{
+			if (view.camera >= cameras.size())
+				return false;
+		}
+
+		for (const Command& command : commands)
+		{
+			switch (command.type)
+			{
+			case TraceCommandType::SetRenderTarget:
+				if (command.a >= (int)targets.size())
+					return false;
+				break;
+			case TraceCommandType::FlushViews:
+				if (command.a < 0 || command.b < 0 || (size_t)command.a + command.b > views.size() || (size_t)command.firstQuad + command.quadCount > quads.size())
+					return false;
+				break;
+			case TraceCommandType::Flush:
+				if (command.a < 0 || command.a >= (int)cameras.size() || (size_t)command.firstQuad + command.quadCount > quads.size())
+					return false;
+				break;
+			case TraceCommandType::Blit:
+				if (command.a < 0 || command.a >= (int)textures.size())
+					return false;
+				break;
+			case TraceCommandType::MergeLightScene:
+				if (command.a < 0 || command.a >= (int)textures.size() || command.b < 0 || command.b >= (int)textures.size())
+					return false;
+				break;
+			default:
+				break;
+			}
+		}
+		return true;
+	}
+
+#pragma endregion
+
+#pragma region Recorder
+
+	void FrameTraceRecorder::Begin(const glm::ivec2& screenSize, RenderTarget* target, int blendMode)
+	{
+		m_trace.Clear();
+		m_textureIndices.clear();
+		m_targetIndices.clear();
+
+		m_trace.screenSize = screenSize;
+		m_recording = true;
+
+		// initial state of the renderer
+		RecordSetRenderTarget(target);
+		RecordSetBlendMode(blendMode);
+	}
+
+	bool FrameTraceRecorder::End(const std::string& path)
+	{
+		if (!m_recording)
+			return false;
+
+		m_recording = false;
+		bool saved = m_trace.Save(path);
+
+		m_trace.Clear();
+		m_textureIndices.clear();
+		m_targetIndices.clear();
+		return saved;
+	}
+
+	void FrameTraceRecorder::RecordSetRenderTarget(RenderTarget* target)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::SetRenderTarget;
+		command.a = -1;
+
+		if (target)
+		{
+			auto it = m_targetIndices.find(target);
+			if (it == m_targetIndices.end())
+			{
+				FrameTrace::TargetData data;
+				data.size = target->GetSize();
+				data.format = target->GetFormat();
+				data.depthStencil = target->HasDepthStencil();
+
+				int index = (int)m_trace.targets.size();
+				m_trace.targets.push_back(data);
+				it = m_targetIndices.emplace(target, index).first;
+
+				// sampling the target later in the frame reads the replayed target, not a snapshot.
+				if (m_textureIndices.find(target->GetTexture().id) == m_textureIndices.end())
+				{
+					FrameTrace::TextureData texture;
+					texture.width = data.size.x;
+					texture.height = data.size.y;
+					texture.renderTarget = index;
+					m_textureIndices[target->GetTexture().id] = (unsigned int)m_trace.textures.size();
+					m_trace.textures.push_back(std::move(texture));
+				}
+			}
+			command.a = it->second;
+		}
+
+		m_trace.commands.push_back(command);
+	}
+
+	void FrameTraceRecorder::RecordClear(const Color& color)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::Clear;
+		command.data = color;
+		m_trace.commands.push_back(command);
+	}
+
+	void FrameTraceRecorder::RecordSetBlendMode(int blendMode)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::SetBlendMode;
+		command.a = blendMode;
+		m_trace.commands.push_back(command);
+	}
+
+	void FrameTraceRecorder::RecordSetScissor(const glm::ivec4& rect)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::SetScissor;
+		command.data = glm::vec4(rect);
+		m_trace.commands.push_back(command);
+	}
+
+	void FrameTraceRecorder::RecordDisableScissor()
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::DisableScissor;
+		m_trace.commands.push_back(command);
+	}
+
+	void FrameTraceRecorder::RecordFlush(const Camera& camera, const Vertex* vertices, const Texture* textures, const unsigned char* opaque, const glm::vec4* clipRects, size_t quadCount)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::Flush;
+		command.a = (int)m_trace.cameras.size();
+		command.firstQuad = RecordQuads(vertices, textures, opaque, clipRects, quadCount);
+		command.quadCount = (unsigned int)quadCount;
+
+		m_trace.cameras.push_back(camera);
+		m_trace.commands.push_back(command);
+	}
+
+	void FrameTraceRecorder::RecordFlushViews(const std::vector<RenderView>& views, const Vertex* vertices, const Texture* textures, const unsigned char* opaque, const glm::vec4* clipRects, size_t quadCount)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::FlushViews;
+		command.a = (int)m_trace.views.size();
+		command.b = 0;
+		command.firstQuad = RecordQuads(vertices, textures, opaque, clipRects, quadCount);
+		command.quadCount = (unsigned int)quadCount;
+
+		for (const RenderView& view : views)
+		{
+			if (view.camera == nullptr)
+				continue;
+
+			FrameTrace::View data;
+			data.camera = (unsigned int)m_trace.cameras.size();
+			data.viewport = view.viewport;
+			data.cull = view.cull;
+			m_trace.cameras.push_back(*view.camera);
+			m_trace.views.push_back(data);
+			command.b++;
+		}
+
+		m_trace.commands.push_back(command);
+	}
+
+	unsigned int FrameTraceRecorder::RecordQuads(const Vertex* vertices, const Texture* textures, const unsigned char* opaque, const glm::vec4* clipRects, size_t quadCount)
+	{
+		unsigned int first = (unsigned int)m_trace.quads.size();
+
+		for (size_t i = 0; i < quadCount; i++)
+		{
+			FrameTrace::Quad quad;
+			for (int v = 0; v < 4; v++)
+			{
+				const Vertex& vertex = vertices[i * 4 + v];
+				quad.vertices[v] = { vertex.pos, vertex.uv, vertex.color };
+			}
+			quad.texture = GetTextureIndex(textures[i]);
+			quad.layer = vertices[i * 4].depth;		// queued quads hold their layer in the depth
+			quad.opaque = opaque[i] != 0;
+
+			size_t clip = static_cast<size_t>(vertices[i * 4].clipIndex);
+			quad.clipped = clip != 0;
+			if (quad.clipped)
+				quad.clipRect = clipRects[clip];
+			m_trace.quads.push_back(quad);
+		}
+
+		return first;
+	}
+
+	void FrameTraceRecorder::RecordBlit(const Texture& texture, float sharpness)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::Blit;
+		command.a = (int)GetTextureIndex(texture);
+		command.value = sharpness;
+		m_trace.commands.push_back(command);
+	}
+
+	void FrameTraceRecorder::RecordMergeLightScene(const Texture& scene, const Texture& light)
+	{
+		FrameTrace::Command command;
+		command.type = TraceCommandType::MergeLightScene;
+		command.a = (int)GetTextureIndex(scene);
+		command.b = (int)GetTextureIndex(light);
+		m_trace.commands.push_back(command);
+	}
+
+	unsigned int FrameTraceRecorder::GetTextureIndex(const Texture& texture)
+	{
+		auto it = m_textureIndices.find(texture.id);
+		if (it != m_textureIndices.end())
+			return it->second;
+
+		FrameTrace::TextureData data;
+
+		GLint width = 0, height = 0, format = 0, magFilter = 0;
+		glBindTexture(GL_TEXTURE_2D, texture.id);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &magFilter);
+
+		data.width = width;
+		data.height = height;
+		data.channelCount = (format == GL_RED || format == GL_R8) ? 1 : 4;	// fonts keep their alpha-only layout
+		data.pixelated = magFilter == GL_NEAREST;
+		data.pixels.resize((size_t)width * height * data.channelCount);
+
+		if (!data.pixels.empty())
+		{
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glGetTexImage(GL_TEXTURE_2D, 0, data.channelCount == 1 ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, data.pixels.data());
+			glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		unsigned int index = (unsigned int)m_trace.textures.size();
+		m_trace.textures.push_back(std::move(data));
+		m_textureIndices[texture.id] = index;
+		return index;
+	}
+
+#pragma endregion
+
+#pragma region Player
+
+	void FrameTracePlayer::Initialize(const FrameTrace& trace)
+	{
+		if (m_initialized)
+			Shutdown();
+
+		m_trace = &trace;
+
+		for (const FrameTrace::TargetData& data : trace.targets)
+		{
+			auto target = std::make_unique<RenderTarget>();
+			if (!target->Create(data.size.x, data.size.y, data.format, data.depthStencil))
+				Utils::Logger::Error("FrameTracePlayer::Initialize : failed to create a (" + std::to_string(data.size.x) + ", " + std::to_string(data.size.y) + ") target.");
+			m_targets.push_back(std::move(target));
+		}
+
+		m_textures.resize(trace.textures.size());
+		for (size_t i = 0; i < trace.textures.size(); i++)
+		{
+			const FrameTrace::TextureData& data = trace.textures[i];
+			if (data.renderTarget < 0 && !data.pixels.empty())
+				m_textures[i].LoadFromData(data.pixels.data(), data.width, data.height, data.channelCount, data.pixelated, false);
+		}
+
+		m_initialized = true;
+	}
+
+	void FrameTracePlayer::Shutdown()
+	{
+		if (!m_initialized)
+			return;
+
+		for (Texture& texture : m_textures)
+		{
+			if (texture.id != 0)
+				texture.Cleanup();
+		}
+		m_textures.clear();
+
+		for (auto& target : m_targets)
+		{
+			target->Cleanup();
+		}
+		m_targets.clear();
+
+		m_trace = nullptr;
+		m_initialized = false;
+	}
+
+	void FrameTracePlayer::Replay(Renderer* renderer)
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("FrameTracePlayer::Replay : not initialized");
+			return;
+		}
+
+		RenderTarget* oldTarget = renderer->GetRenderTarget();
+		const Camera* oldCamera = &renderer->GetCamera();
+		Renderer::BlendMode oldBlendMode = renderer->GetBlendMode();
+		float oldLayer = renderer->GetLayer();
+		bool oldOpaque = renderer->IsOpaque();
+
+		renderer->SetCamera(m_camera);
+
+		for (const FrameTrace::Command& command : m_trace->commands)
+		{
+			switch (command.type)
+			{
+			case TraceCommandType::SetRenderTarget:
+				renderer->SetRenderTarget(command.a < 0 ? nullptr : m_targets[command.a].get());
+				break;
+			case TraceCommandType::Clear:
+				renderer->Clear(command.data);
+				break;
+			case TraceCommandType::SetBlendMode:
+				renderer->SetBlendMode((Renderer::BlendMode)command.a);
+				break;
+			case TraceCommandType::SetScissor:
+				renderer->SetScissorRect(glm::ivec4(command.data));
+				break;
+			case TraceCommandType::DisableScissor:
+				renderer->DisableScissor();
+				break;
+			case TraceCommandType::Flush:
+			case TraceCommandType::FlushViews:
+			{
+				for (unsigned int i = command.firstQuad; i < command.firstQuad + command.quadCount; i++)
+				{
+					const FrameTrace::Quad& quad = m_trace->quads[i];
+					renderer->SetLayer(quad.layer);
+					renderer->SetOpaque(quad.opaque);
+
+					std::array<Vertex, 4> vertices = {
+						Vertex(quad.vertices[0].pos, quad.vertices[0].uv, quad.vertices[0].color, 0.f),
+						Vertex(quad.vertices[1].pos, quad.vertices[1].uv, quad.vertices[1].color, 0.f),
+						Vertex(quad.vertices[2].pos, quad.vertices[2].uv, quad.vertices[2].color, 0.f),
+						Vertex(quad.vertices[3].pos, quad.vertices[3].uv, quad.vertices[3].color, 0.f)
+					};
+					if (quad.clipped)
+						renderer->PushClipRect({ quad.clipRect.x, quad.clipRect.y, quad.clipRect.z - quad.clipRect.x, quad.clipRect.w - quad.clipRect.y });
+					renderer->DrawQuad(vertices, GetTexture(quad.texture));
+					if (quad.clipped)
+						renderer->PopClipRect();
+				}
+
+				if (command.type == TraceCommandType::Flush)
+				{
+					m_camera = m_trace->cameras[command.a];
+					renderer->Flush();
+					break;
+				}
+
+				// all the cameras are copied before the views point to them.
+				m_viewCameras.clear();
+				for (int v = command.a; v < command.a + command.b; v++)
+					m_viewCameras.push_back(m_trace->cameras[m_trace->views[v].camera]);
+
+				std::vector<RenderView> views;
+				for (int v = command.a; v < command.a + command.b; v++)
+				{
+					const FrameTrace::View& view = m_trace->views[v];
+					views.push_back({ &m_viewCameras[v - command.a], view.viewport, view.cull });
+				}
+				renderer->FlushViews(views);
+				break;
+			}
+			case TraceCommandType::Blit:
+				renderer->BlitImage(GetTexture(command.a), command.value);
+				break;
+			case TraceCommandType::MergeLightScene:
+				renderer->MergeLightScene(GetTexture(command.a), GetTexture(command.b));
+				break;
+			default:
+				break;
+			}
+		}
+
+		renderer->Flush();
+		renderer->DisableScissor();
+		renderer->SetLayer(oldLayer);
+		renderer->SetOpaque(oldOpaque);
+		renderer->SetBlendMode(oldBlendMode);
+		renderer->SetCamera(*oldCamera);
+		renderer->SetRenderTarget(oldTarget);
+	}
+
+	const Texture& FrameTracePlayer::GetTexture(unsigned int index) const
+	{
+		int target = m_trace->textures[index].renderTarget;
+		if (target >= 0)
+			return m_targets[target]->GetTexture();
+		return m_textures[index];
+	}
+
+#pragma endregion
+
+}
@@ -2,6 +2,14 @@
 
 #include "LittleEngine/Utils/logger.h"
 
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
 
 namespace LittleEngine::Graphics
 {
@@ -32,6 +40,64 @@ namespace LittleEngine::Graphics
 		}
     )";
 
+	// one instance per obstacle edge, 9 vertices: the edge and its extrusion away from the light,
+	// a fan closed by the rays of p1, p2 and their bisector, just outside of the light circle.
+	const std::string edgeShadowVertexShader = R"(
+		#version 330 core
+		layout(location = 0) in vec4 aEdge;	// {p1, p2}, CCW obstacle
+
+		uniform mat4 proj;
+		uniform mat4 view;
+
+		uniform vec2 uLightPos;
+		uniform float uLightRadius;
+
+		void main()
+		{
+			// corners 0: p1, 1: p2, 2: p2 extruded, 3: bisector extruded, 4: p1 extruded
+			int corner = int[9](0, 1, 2, 0, 2, 3, 0, 3, 4)[gl_VertexID];
+
+			// edges not facing the light (same test as LightSource::GetShadowQuads) or out of its radius collapse to a point.
+			vec2 edge = aEdge.zw - aEdge.xy;
+			vec2 toLight = uLightPos - aEdge.xy;
+			float closest = clamp(dot(toLight, edge) / dot(edge, edge), 0.0, 1.0);
+			if (edge.x * toLight.y - edge.y * toLight.x >= 0.0 || length(edge * closest - toLight) >= uLightRadius)
+			{
+				gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+				return;
+			}
+
+			vec2 toP1 = aEdge.xy - uLightPos;
+			vec2 toP2 = aEdge.zw - uLightPos;
+			vec2 dir1 = normalize(toP1);
+			vec2 dir2 = normalize(toP2);
+			vec2 bisector = normalize(dir1 + dir2);
+
+			// the rays are at most angle / 2 apart, the segments between points at radius / cos(angle / 4)
+			// on them stay outside of the circle.
+			float cosHalf = sqrt(max((1.0 + dot(dir1, dir2)) * 0.5, 0.0));
+			float extrusion = uLightRadius / sqrt((1.0 + cosHalf) * 0.5);
+
+			vec2 pos;
+			if (corner == 0)
+				pos = aEdge.xy;
+			else if (corner == 1)
+				pos = aEdge.zw;
+			else if (corner == 2)
+				pos = uLightPos + dir2 * max(extrusion, length(toP2));
+			else if (corner == 4)
+				pos = uLightPos + dir1 * max(extrusion, length(toP1));
+			else
+			{
+				// not in front of the edge
+				float edgeDistance = (toP1.x * edge.y - toP1.y * edge.x) / (bisector.x * edge.y - bisector.y * edge.x);
+				pos = uLightPos + bisector * max(extrusion, edgeDistance);
+			}
+
+			gl_Position = proj * view * vec4(pos, 0.0, 1.0);
+		}
+    )";
+
 	const std::string lightVertexShader = R"(
 		#version 330 core
 		layout(location = 0) in vec2 aPos;      // NDC
@@ -90,24 +156,463 @@ namespace LittleEngine::Graphics
 	)";
 
 
-	std::vector<ShadowQuad> LightSource::GetShadowQuads(const Math::Polygon& poly) const
+	// evaluates every light touching the tile of the pixel (tiled lighting).
+	const std::string tiledLightFragmentShader = R"(
+		#version 330 core
+
+		out vec4 FragColor;
+
+
+		uniform mat4 uInvProj;
+		uniform mat4 uInvView;
+
+		uniform vec2 uScreenSize;
+
+		uniform samplerBuffer uLightData;		// 2 texels per light: {position, radius, intensity}, {color, 0}
+		uniform usamplerBuffer uTileRanges;		// {first, count} of the lights of each tile in uTileLights
+		uniform usamplerBuffer uTileLights;		// light indices, tile after tile
+
+		uniform int uTileSize;
+		uniform int uTileCountX;
+
+		void main()
+		{
+			vec2 ndc = (gl_FragCoord.xy / uScreenSize) * 2.0 - 1.0;
+			vec4 worldSpace = uInvView * uInvProj * vec4(ndc, 0.0, 1.0);
+			vec2 worldPos = worldSpace.xy / worldSpace.w;
+
+			ivec2 tile = ivec2(gl_FragCoord.xy) / uTileSize;
+			uvec2 range = texelFetch(uTileRanges, tile.y * uTileCountX + tile.x).xy;
+
+			vec3 light = vec3(0.0);
+			for (uint i = 0u; i < range.y; i++)
+			{
+				int index = int(texelFetch(uTileLights, int(range.x + i)).r);
+				vec4 data = texelFetch(uLightData, index * 2);
+				vec3 color = texelFetch(uLightData, index * 2 + 1).rgb;
+
+				// same falloff as the per light pass
+				float dist = length(worldPos - data.xy);
+				if (dist > data.z)
+					continue;
+
+				float attenuation = 1.0 - (dist / data.z);
+				light += color * attenuation * attenuation * data.w;
+			}
+
+			FragColor = vec4(light, 1.0);
+		}
+	)";
+
+
+	// distance from each shadowed light to the first obstacle in the direction of the pixel column (polar shadow map).
+	const std::string polarMapFragmentShader = R"(
+		#version 330 core
+
+		out vec4 FragColor;
+
+
+		uniform samplerBuffer uLightData;	// 2 texels per light: {position, radius, intensity}, {color, 0}
+		uniform sampler2D uOcclusion;		// r < 0.5 inside the obstacles
+		uniform vec4 uOcclusionRect;		// world rect {min x, min y, max x, max y} of the occlusion texture
+
+		uniform float uResolution;			// directions per light
+
+		void main()
+		{
+			int row = int(gl_FragCoord.y);
+			if (row * 2 >= textureSize(uLightData))
+			{
+				FragColor = vec4(1.0);
+				return;
+			}
+
+			vec4 data = texelFetch(uLightData, row * 2);
+			float angle = gl_FragCoord.x / uResolution * 6.28318530718;
+			vec2 direction = vec2(cos(angle), sin(angle));
+
+			// one sample per occlusion texel along the ray
+			vec2 rectSize = uOcclusionRect.zw - uOcclusionRect.xy;
+			vec2 texel = rectSize / vec2(textureSize(uOcclusion, 0));
+			int steps = int(clamp(data.z / min(texel.x, texel.y), 1.0, 4096.0));
+
+			float hit = 1.0;
+			for (int i = 1; i <= steps; i++)
+			{
+				vec2 uv = (data.xy + direction * (data.z * float(i) / float(steps)) - uOcclusionRect.xy) / rectSize;
+				if (all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0))) && texture(uOcclusion, uv).r < 0.5)
+				{
+					hit = (float(i) - 0.5) / float(steps);	// the obstacle starts between the last two samples
+					break;
+				}
+			}
+
+			FragColor = vec4(hit, 0.0, 0.0, 1.0);
+		}
+	)";
+
+	// light pass of a light shadowed by its row of the polar shadow map.
+	const std::string polarLightFragmentShader = R"(
+		#version 330 core
+
+		out vec4 FragColor;
+
+
+		uniform mat4 uInvProj;
+		uniform mat4 uInvView;
+
+		uniform vec2 uLightPos;
+		uniform vec3 uLightColor;
+		uniform float uLightRadius;
+		uniform float uLightIntensity;
+
+		uniform vec2 uScreenSize;
+
+		uniform sampler2D uPolarMap;		// distance to the first obstacle / radius, one row per light
+		uniform int uPolarRow;
+
+		void main()
+		{
+			vec2 ndc = (gl_FragCoord.xy / uScreenSize) * 2.0 - 1.0;
+			vec4 worldSpace = uInvView * uInvProj * vec4(ndc, 0.0, 1.0);
+			vec2 worldPos = worldSpace.xy / worldSpace.w;
+
+			vec2 delta = worldPos - uLightPos;
+			float dist = length(delta);
+			if (dist > uLightRadius)
+				discard;
+
+			float attenuation = 1.0 - (dist / uLightRadius);
+			attenuation = attenuation * attenuation;
+
+			// compared with the neighbouring directions too, softens the aliasing of the shadow edges.
+			int resolution = textureSize(uPolarMap, 0).x;
+			int column = int(fract(atan(delta.y, delta.x) / 6.28318530718) * float(resolution));
+			float lit = 0.0;
+			for (int k = -1; k <= 1; k++)
+			{
+				float occluder = texelFetch(uPolarMap, ivec2((column + k + resolution) % resolution, uPolarRow), 0).r;
+				lit += dist / uLightRadius <= occluder ? 1.0 : 0.0;
+			}
+
+			FragColor = vec4(uLightColor * attenuation * uLightIntensity * (lit / 3.0), 1.0);
+		}
+	)";
+
+
+	// pixel rect {x, y, w, h} touched by the light in a target of the given size (w = h = 0 if off screen),
+	// from its bounding square (conservative if the camera is rotated) with a 1 pixel margin.
+	static glm::ivec4 GetLightScreenRect(const LightSource& light, const glm::mat4& viewProjection, const glm::ivec2& size)
 	{
-		std::vector<ShadowQuad> shadowQuads;
-		for (const Math::Edge& edge : poly.GetEdges())
+		glm::vec2 min{ std::numeric_limits<float>::max() };
+		glm::vec2 max{ std::numeric_limits<float>::lowest() };
+		for (int c = 0; c < 4; c++)
+		{
+			glm::vec2 corner = light.position + light.radius * glm::vec2(c & 1 ? 1.f : -1.f, c & 2 ? 1.f : -1.f);
+			glm::vec4 clip = viewProjection * glm::vec4(corner, 0.f, 1.f);
+			glm::vec2 pixel = (glm::vec2(clip) / clip.w * 0.5f + 0.5f) * glm::vec2(size);
+			min = glm::min(min, pixel);
+			max = glm::max(max, pixel);
+		}
+
+		glm::ivec2 p0 = glm::clamp(glm::ivec2(glm::floor(min)) - 1, glm::ivec2(0), size);
+		glm::ivec2 p1 = glm::clamp(glm::ivec2(glm::ceil(max)) + 1, glm::ivec2(0), size);
+		if (light.radius <= 0.f || p0.x >= p1.x || p0.y >= p1.y)
+			return { 0, 0, 0, 0 };
+		return { p0, p1 - p0 };
+	}
+
+	// intersection of two pixel rects {x, y, w, h} (w = h = 0 if they do not overlap).
+	static glm::ivec4 IntersectScreenRects(const glm::ivec4& a, const glm::ivec4& b)
+	{
+		glm::ivec2 p0 = glm::max(glm::ivec2(a.x, a.y), glm::ivec2(b.x, b.y));
+		glm::ivec2 p1 = glm::min(glm::ivec2(a.x + a.z, a.y + a.w), glm::ivec2(b.x + b.z, b.y + b.w));
+		if (p0.x >= p1.x || p0.y >= p1.y)
+			return { 0, 0, 0, 0 };
+		return { p0, p1 - p0 };
+	}
+
+
+	// clips the segment to the rect {min x, min y, max x, max y} (Liang-Barsky), false if it is outside.
+	static bool ClipSegment(Math::Edge& edge, const glm::vec4& rect)
+	{
+		glm::vec2 delta = edge.p2 - edge.p1;
+		float t0 = 0.f;
+		float t1 = 1.f;
+		const float p[4] = { -delta.x, delta.x, -delta.y, delta.y };
+		const float q[4] = { edge.p1.x - rect.x, rect.z - edge.p1.x, edge.p1.y - rect.y, rect.w - edge.p1.y };
+		for (int i = 0; i < 4; i++)
 		{
-			if (Math::ThreePointOrientation(edge.p1, edge.p2, position) == 1)	// if clockwise, position in on the right side of the edge (faces light)
+			if (p[i] == 0.f)
 			{
-				glm::vec2 dir1 = glm::normalize(edge.p1 - position);
-				glm::vec2 dir2 = glm::normalize(edge.p2 - position);
-				// Create shadow quad vertices
-				glm::vec2 p1 = edge.p1;
-				glm::vec2 p2 = edge.p2;
-				glm::vec2 p3 = edge.p2 + dir2 * radius * 100.f;
-				glm::vec2 p4 = edge.p1 + dir1 * radius * 100.f;
-				shadowQuads.push_back({ p1, p2, p3, p4 });
+				if (q[i] < 0.f)
+					return false;	// parallel and outside
+				continue;
 			}
+
+			float t = q[i] / p[i];
+			if (p[i] < 0.f)
+				t0 = std::max(t0, t);
+			else
+				t1 = std::min(t1, t);
 		}
 
+		if (t0 > t1)
+			return false;
+
+		edge = { edge.p1 + delta * t0, edge.p1 + delta * t1 };
+		return true;
+	}
+
+
+	// shadow quad of the edge (p1, p2) facing the light, extruded just outside of the light circle:
+	// to radius / cos(angle / 2) on the rays of p1 and p2, so the far side does not cut the circle.
+	// edges seen under more than 90 degrees are split at their bisector to keep the extrusion short.
+	template<typename Emit>
+	static void EmitShadowQuad(Emit& emit, const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& light, float radius)
+	{
+		glm::vec2 edge = p2 - p1;
+		float closest = glm::clamp(glm::dot(light - p1, edge) / glm::dot(edge, edge), 0.f, 1.f);
+		if (glm::length(p1 + edge * closest - light) >= radius)
+			return;	// out of the light
+
+		glm::vec2 dir1 = glm::normalize(p1 - light);
+		glm::vec2 dir2 = glm::normalize(p2 - light);
+		float cosAngle = glm::dot(dir1, dir2);
+
+		if (cosAngle < 0.f)
+		{
+			glm::vec2 bisector = dir1 + dir2;
+			float denominator = bisector.x * edge.y - bisector.y * edge.x;
+			if (denominator == 0.f)
+				return;	// the light is on the edge
+
+			glm::vec2 toP1 = p1 - light;
+			glm::vec2 middle = light + bisector * ((toP1.x * edge.y - toP1.y * edge.x) / denominator);
+			EmitShadowQuad(emit, p1, middle, light, radius);
+			EmitShadowQuad(emit, middle, p2, light, radius);
+			return;
+		}
+
+		float extrusion = radius / std::sqrt((1.f + cosAngle) * 0.5f);
+		glm::vec2 p3 = light + dir2 * std::max(extrusion, glm::length(p2 - light));
+		glm::vec2 p4 = light + dir1 * std::max(extrusion, glm::length(p1 - light));
+		emit(ShadowQuad{ p1, p2, p3, p4 });
+	}
+
+	// calls emit(ShadowQuad) for each shadow quad of the polygon (see LightSource::GetShadowQuads), without allocation.
+	template<typename Emit>
+	static void EmitShadowQuads(const LightSource& light, const Math::Polygon& poly, bool convex, Emit& emit)
+	{
+		size_t first, last;
+		if (convex && poly.FindTangents(light.position, first, last))
+		{
+			// the facing edges go from first to last, the quad of their chord covers their shadows.
+			EmitShadowQuad(emit, poly.vertices[first], poly.vertices[last], light.position, light.radius);
+			return;
+		}
+
+		const std::vector<glm::vec2>& vertices = poly.vertices;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const glm::vec2& p1 = vertices[i];
+			const glm::vec2& p2 = vertices[(i + 1) % vertices.size()];
+			if (Math::ThreePointOrientation(p1, p2, light.position) == 1)	// if clockwise, position in on the right side of the edge (faces light)
+				EmitShadowQuad(emit, p1, p2, light.position, light.radius);
+		}
+	}
+
+	// visibility polygon of origin in the square of half size radius (see LightSystem::ComputeVisibilityPolygon),
+	// written to vertices (GetVisibilityCapacity of them at most), returns the vertex count.
+	//
+	// angular sweep around the origin: the endpoints of the edges are sorted by angle, and the edges
+	// crossed by the sweep ray are kept in a set ordered by distance to the origin. The nearest edge only
+	// changes at an endpoint, where the boundary jumps from the previous nearest edge to the new one.
+	// edges: the edge pieces, angles: {begin, end} angle of each piece, events: scratch buffers.
+	static size_t SweepVisibility(const glm::vec2& origin, float radius, Math::Polygon* const* obstacles, size_t obstacleCount,
+		glm::vec2* vertices, std::vector<Math::Edge>& edges, std::vector<float>& angles, std::vector<unsigned int>& events)
+	{
+		if (radius <= 0.f)
+			return 0;
+
+		const float pi = glm::pi<float>();
+
+		// angle of the point in [-pi, pi], a point on the cut (the ray towards -x) takes the side of the other end of its edge.
+		auto angleOf = [&origin, pi](const glm::vec2& point, const glm::vec2& other)
+		{
+			if (point.y == origin.y && point.x < origin.x)
+				return other.y >= origin.y ? pi : -pi;
+			return std::atan2(point.y - origin.y, point.x - origin.x);
+		};
+
+		// pieces run counterclockwise around the origin, the ones crossing the cut are split on it.
+		edges.clear();
+		angles.clear();
+		auto addEdge = [&](const glm::vec2& p1, const glm::vec2& p2)
+		{
+			float a1 = angleOf(p1, p2);
+			float a2 = angleOf(p2, p1);
+			if (a1 == a2)
+				return;	// seen edge-on
+
+			if (std::abs(a1 - a2) <= pi)
+			{
+				edges.push_back(a1 < a2 ? Math::Edge{ p1, p2 } : Math::Edge{ p2, p1 });
+				angles.push_back(std::min(a1, a2));
+				angles.push_back(std::max(a1, a2));
+				return;
+			}
+
+			const glm::vec2& upper = a1 > a2 ? p1 : p2;	// above the cut, angle close to pi
+			const glm::vec2& lower = a1 > a2 ? p2 : p1;
+			glm::vec2 cut = glm::mix(upper, lower, (origin.y - upper.y) / (lower.y - upper.y));
+			cut.y = origin.y;
+
+			edges.push_back({ upper, cut });
+			angles.push_back(std::max(a1, a2));
+			angles.push_back(pi);
+			edges.push_back({ cut, lower });
+			angles.push_back(-pi);
+			angles.push_back(std::min(a1, a2));
+		};
+
+		// the edges in the square of the light, and the square itself so every ray hits something.
+		glm::vec4 rect{ origin - radius, origin + radius };
+		for (size_t o = 0; o < obstacleCount; o++)
+		{
+			const std::vector<glm::vec2>& points = obstacles[o]->vertices;
+			for (size_t i = 0; i < points.size(); i++)
+			{
+				// the rays always hit an edge facing the origin first (closed obstacles)
+				Math::Edge edge{ points[i], points[(i + 1) % points.size()] };
+				if (Math::ThreePointOrientation(edge.p1, edge.p2, origin) != 1)
+					continue;
+
+				if (ClipSegment(edge, rect))
+					addEdge(edge.p1, edge.p2);
+			}
+		}
+
+		const glm::vec2 corners[4] = { { rect.x, rect.y }, { rect.z, rect.y }, { rect.z, rect.w }, { rect.x, rect.w } };
+		for (int i = 0; i < 4; i++)
+			addEdge(corners[i], corners[(i + 1) % 4]);
+
+		// event 2 * e begins the piece e, 2 * e + 1 ends it. At the same angle, the ends come first.
+		events.resize(angles.size());
+		for (unsigned int e = 0; e < events.size(); e++)
+			events[e] = e;
+		std::sort(events.begin(), events.end(), [&angles](unsigned int a, unsigned int b)
+		{
+			if (angles[a] != angles[b])
+				return angles[a] < angles[b];
+			return (a & 1) > (b & 1);
+		});
+
+		// distance from the origin to the line of the edge along the direction.
+		auto distance = [&origin, &edges](unsigned int e, const glm::vec2& direction)
+		{
+			const Math::Edge& edge = edges[e];
+			glm::vec2 segment = edge.p2 - edge.p1;
+			glm::vec2 toStart = edge.p1 - origin;
+			float denominator = direction.x * segment.y - direction.y * segment.x;
+			if (denominator == 0.f)
+				return std::min(glm::length(toStart), glm::length(edge.p2 - origin));
+			return (toStart.x * segment.y - toStart.y * segment.x) / denominator;
+		};
+
+		// the edges do not cross, so their order along the ray does not change while they are active:
+		// they are only compared when one is inserted, along the ray of the current event.
+		float sweepAngle = -pi;
+		glm::vec2 sweepDirection = { -1.f, 0.f };
+		auto closer = [&](unsigned int a, unsigned int b)
+		{
+			if (a == b)
+				return false;
+
+			float da = distance(a, sweepDirection);
+			float db = distance(b, sweepDirection);
+			float tolerance = 1e-5f * std::max(std::abs(da), std::abs(db));
+			if (std::abs(da - db) > tolerance)
+				return da < db;
+
+			// same point (edges touching on the ray): compared a bit further, where both are still active.
+			float probe = sweepAngle + 0.5f * (std::min(angles[2 * a + 1], angles[2 * b + 1]) - sweepAngle);
+			glm::vec2 direction = { std::cos(probe), std::sin(probe) };
+			da = distance(a, direction);
+			db = distance(b, direction);
+			if (da != db)
+				return da < db;
+			return a < b;
+		};
+		std::set<unsigned int, decltype(closer)> active(closer);
+		std::vector<std::set<unsigned int, decltype(closer)>::iterator> handles(edges.size(), active.end());
+
+		size_t count = 0;
+		auto addVertex = [&](unsigned int e)
+		{
+			glm::vec2 point = origin + sweepDirection * distance(e, sweepDirection);
+			if (count == 0 || vertices[count - 1] != point)
+				vertices[count++] = point;
+		};
+
+		for (size_t first = 0; first < events.size();)
+		{
+			sweepAngle = angles[events[first]];
+			sweepDirection = { std::cos(sweepAngle), std::sin(sweepAngle) };
+
+			bool hadNearest = !active.empty();
+			unsigned int nearest = hadNearest ? *active.begin() : 0;
+
+			size_t last = first;
+			for (; last < events.size() && angles[events[last]] == sweepAngle; last++)
+			{
+				unsigned int event = events[last];
+				unsigned int e = event / 2;
+				if (event & 1)
+				{
+					if (handles[e] != active.end())
+						active.erase(handles[e]);
+					handles[e] = active.end();
+				}
+				else
+				{
+					handles[e] = active.insert(e).first;
+				}
+			}
+			first = last;
+
+			// the boundary jumps from the previous nearest edge to the new one along the ray.
+			bool hasNearest = !active.empty();
+			if (hadNearest && hasNearest && *active.begin() == nearest)
+				continue;
+
+			if (hadNearest)
+				addVertex(nearest);
+			if (hasNearest)
+				addVertex(*active.begin());
+		}
+
+		if (count > 1 && vertices[count - 1] == vertices[0])
+			count--;	// the sweep ends where it started
+		return count;
+	}
+
+	// upper bound of the vertex count of SweepVisibility: each edge (and side of the square) is split
+	// at most once, each of its ends adds 2 vertices at most.
+	static size_t GetVisibilityCapacity(Math::Polygon* const* obstacles, size_t obstacleCount)
+	{
+		size_t edgeCount = 4;
+		for (size_t o = 0; o < obstacleCount; o++)
+			edgeCount += obstacles[o]->vertices.size();
+		return edgeCount * 8;
+	}
+
+
+	std::vector<ShadowQuad> LightSource::GetShadowQuads(const Math::Polygon& poly, bool convex) const
+	{
+		std::vector<ShadowQuad> shadowQuads;
+		auto emit = [&shadowQuads](const ShadowQuad& quad) { shadowQuads.push_back(quad); };
+		EmitShadowQuads(*this, poly, convex, emit);
 		return shadowQuads;
 	}
 
@@ -129,7 +634,7 @@ namespace LittleEngine::Graphics
 
 #pragma region Light System
 
-	void LightSystem::Initialize(size_t maxQuadCount)
+	void LightSystem::Initialize(size_t maxQuadCount, int workerCount)
 	{
 		if (!internal::g_initialized)
 		{
@@ -159,12 +664,76 @@ namespace LittleEngine::Graphics
 		glEnableVertexAttribArray(0);
 		glBindVertexArray(0);
 
+		// visibility fans, streamed every frame
+		glGenVertexArrays(1, &m_fanVAO);
+		glGenBuffers(1, &m_fanVBO);
+		glBindVertexArray(m_fanVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_fanVBO);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+		glEnableVertexAttribArray(0);
+		glBindVertexArray(0);
+
+		if (workerCount < 0)
+			workerCount = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+		m_workers.Initialize(static_cast<unsigned int>(workerCount));
+
+		// precomputed shadows, the buffer of each light is bound when it is drawn
+		glGenVertexArrays(1, &m_precomputedVAO);
+		glBindVertexArray(m_precomputedVAO);
+		glEnableVertexAttribArray(0);
+		glBindVertexArray(0);
+
+		// edge buffer, filled at the first frame
+		glGenVertexArrays(1, &m_edgeVAO);
+		glGenBuffers(1, &m_edgeVBO);
+		glBindVertexArray(m_edgeVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_edgeVBO);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribDivisor(0, 1);	// one edge per instance
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_edgeCapacity = 0;
+		m_edgeBufferDirty = true;
+
 		// initialize shaders
 		m_lightShader.Create(lightVertexShader, lightFragmentShader, false);
 		m_shadowShader.Create(shadowVertexShader, shadowFragmentShader, false);
+		m_edgeShadowShader.Create(edgeShadowVertexShader, shadowFragmentShader, false);
+
+		m_tiledLightShader.Create(lightVertexShader, tiledLightFragmentShader, false);
+		m_tiledLightShader.Use();
+		m_tiledLightShader.SetInt("uLightData", 0);
+		m_tiledLightShader.SetInt("uTileRanges", 1);
+		m_tiledLightShader.SetInt("uTileLights", 2);
+
+		m_polarMapShader.Create(lightVertexShader, polarMapFragmentShader, false);
+		m_polarMapShader.Use();
+		m_polarMapShader.SetInt("uLightData", 0);
+		m_polarMapShader.SetInt("uOcclusion", 1);
+
+		m_visibilityLightShader.Create(shadowVertexShader, lightFragmentShader, false);
+
+		m_polarLightShader.Create(lightVertexShader, polarLightFragmentShader, false);
+		m_polarLightShader.Use();
+		m_polarLightShader.SetInt("uPolarMap", 0);
+
+		// texture buffers of the tiled lighting, their storage is allocated at the first upload.
+		const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+		GLuint* buffers[3] = { &m_lightDataBuffer, &m_tileRangeBuffer, &m_tileLightBuffer };
+		GLuint* textures[3] = { &m_lightDataTexture, &m_tileRangeTexture, &m_tileLightTexture };
+		for (int i = 0; i < 3; i++)
+		{
+			glGenBuffers(1, buffers[i]);
+			glBindBuffer(GL_TEXTURE_BUFFER, *buffers[i]);
+			glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
 
-		// initialize temporary light FBO
-		m_tempLightFBO.Create(1, 1, GL_RGB16F);
+			glGenTextures(1, textures[i]);
+			glBindTexture(GL_TEXTURE_BUFFER, *textures[i]);
+			glTexBuffer(GL_TEXTURE_BUFFER, formats[i], *buffers[i]);
+		}
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
 	}
 
@@ -177,17 +746,43 @@ namespace LittleEngine::Graphics
 		}
 		m_lightSources.clear();
 		m_obstacles.clear();
+		m_obstacleGrid.Clear();
+		ReleasePrecomputedShadows();
+		m_convexObstacles.clear();
+		m_changedObstacleBounds.clear();
+		m_precomputedShadowsDirty = true;
 		//m_lightShader.Cleanup();
 		//m_shadowShader.Cleanup();
 
-		m_tempLightFBO.Cleanup();
-
 		glDeleteVertexArrays(1, &shadowVAO);
 		glDeleteBuffers(1, &shadowVBO);
 
 		shadowVAO = 0;
 		shadowVBO = 0;
 
+		glDeleteVertexArrays(1, &m_edgeVAO);
+		glDeleteBuffers(1, &m_edgeVBO);
+		m_edgeVAO = m_edgeVBO = 0;
+
+		glDeleteVertexArrays(1, &m_fanVAO);
+		glDeleteBuffers(1, &m_fanVBO);
+		m_fanVAO = m_fanVBO = 0;
+
+		glDeleteVertexArrays(1, &m_precomputedVAO);
+		m_precomputedVAO = 0;
+
+		m_workers.Shutdown();
+
+		glDeleteTextures(1, &m_lightDataTexture);
+		glDeleteTextures(1, &m_tileRangeTexture);
+		glDeleteTextures(1, &m_tileLightTexture);
+		glDeleteBuffers(1, &m_lightDataBuffer);
+		glDeleteBuffers(1, &m_tileRangeBuffer);
+		glDeleteBuffers(1, &m_tileLightBuffer);
+
+		m_lightDataTexture = m_tileRangeTexture = m_tileLightTexture = 0;
+		m_lightDataBuffer = m_tileRangeBuffer = m_tileLightBuffer = 0;
+
 		m_initialized = false;
 
 	}
@@ -215,231 +810,815 @@ namespace LittleEngine::Graphics
 		// store previous renderTarget to restore it afterward.
 		RenderTarget* old = renderer->GetRenderTarget();
 
-		// recreate the temp FBO for correct size.
-		if (m_tempLightFBO.GetSize() != target->GetSize())	
+		renderer->SetRenderTarget(target);
+
+		// clear target and set background lighting color
+		renderer->Clear(color);
+
+		if (m_tiledLighting)
+			RenderTiledLights(renderer, target, enableShadows);
+
+		RenderLightPasses(renderer, target, enableShadows, false);
+
+		renderer->SetBlendMode(Renderer::BlendMode::Alpha); // reset blend mode to default
+		renderer->SetRenderTarget(old); // reset to previous target
+		renderer->shader.Use();
+
+	}
+
+	void LightSystem::RenderPrecomputedLighting(Renderer* renderer, RenderTarget* target, bool enableShadows, const Color& color)
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("LightSystem::RenderLighting : LightSystem not initialized.");
+			return;
+		}
+
+		if (!renderer)
 		{
-			m_tempLightFBO.Cleanup(); // cleanup previous FBO if it exists
-			glm::ivec2 size = target->GetSize();
-			m_tempLightFBO.Create(size.x, size.y, GL_RGB16F);
+			Utils::Logger::Warning("LightSystem::RenderLighting : Renderer is null.");
+			return;
 		}
 
+		if (!target)
+		{
+			Utils::Logger::Warning("LightSystem::RenderLighting : RenderTarget is null.");
+			return;
+		}
+
+		if (enableShadows)
+			UpdatePrecomputedShadows();
+
+		// store previous renderTarget to restore it afterward.
+		RenderTarget* old = renderer->GetRenderTarget();
 
 		renderer->SetRenderTarget(target);
 
 		// clear target and set background lighting color
 		renderer->Clear(color);
 
+		if (m_tiledLighting)
+			RenderTiledLights(renderer, target, enableShadows);
+
+		RenderLightPasses(renderer, target, enableShadows, true);
+
+		renderer->SetBlendMode(Renderer::BlendMode::Alpha); // reset blend mode to default
+		renderer->SetRenderTarget(old); // reset to previous target
+		renderer->shader.Use();
+
+	}
+
+	void LightSystem::RenderLightPasses(Renderer* renderer, RenderTarget* target, bool enableShadows, bool precomputed)
+	{
 		const Camera& camera = renderer->GetCamera();
+		glm::mat4 viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+
+		// with a stencil buffer, the shadows mask the light in the target itself.
+		// otherwise the light is drawn into a temporary target, darkened by the shadows, then added to the target.
+		bool stencilShadows = target->HasDepthStencil();
+		RenderTarget* tempLightFBO = nullptr;
+
+		// the polar maps of all the shadowed lights are computed at once, before the passes.
+		RenderTarget* polarMap = nullptr;
+		if (enableShadows && !precomputed && m_shadowTechnique == ShadowTechnique::PolarMap)
+			polarMap = RenderPolarShadowMap(renderer, target);
+
+		bool visibilityFans = enableShadows && !precomputed && m_shadowTechnique == ShadowTechnique::VisibilityPolygon;
+		if (visibilityFans)
+			PrepareVisibilityFans(camera, target->GetSize());
+
+		// the light rects are intersected with the scissor of the caller, restored after each light.
+		bool userScissor = renderer->IsScissorEnabled();
+		glm::ivec4 userScissorRect = renderer->GetScissorRect();
+		auto restoreScissor = [&]() {
+			if (userScissor)
+				renderer->SetScissorRect(userScissorRect);
+			else
+				renderer->DisableScissor();
+		};
 
-		for (const auto& lightSource : m_lightSources)
+		for (size_t i = 0; i < m_lightSources.size(); i++)
 		{
+			const auto& lightSource = m_lightSources[i];
+
 			if (!lightSource) continue; // skip null light sources
 
-			renderer->SetBlendMode(Renderer::BlendMode::None);
+			if (IsTiled(*lightSource, enableShadows)) continue;	// already in the tiled pass
 
-			renderer->SetRenderTarget(&m_tempLightFBO);
-			renderer->Clear(Colors::Black); // clear the temporary light FBO
+			// the clear, the light, the shadows and the blit only touch the pixels of the light.
+			glm::ivec4 lightRect = GetLightScreenRect(*lightSource, viewProjection, target->GetSize());
+			if (userScissor)
+				lightRect = IntersectScreenRects(lightRect, userScissorRect);
+			if (lightRect.z == 0) continue;	// off screen
+
+			bool shadowed = enableShadows && lightSource->castShadows;
 
-			// Set up light shader
-			m_lightShader.Use();
-			m_lightShader.SetMat4("uInvProj", glm::inverse(camera.GetProjectionMatrix()));
-			m_lightShader.SetMat4("uInvView", glm::inverse(camera.GetViewMatrix()));
-			m_lightShader.SetVec2("uScreenSize", target->GetSize());
-			m_lightShader.SetVec2("uLightPos", lightSource->position);
-			m_lightShader.SetVec3("uLightColor", lightSource->color);
-			m_lightShader.SetFloat("uLightRadius", lightSource->radius);
-			m_lightShader.SetFloat("uLightIntensity", lightSource->intensity);
-			// Draw the light volume
-			renderer->FlushFullscreenQuad();
+			if (shadowed && visibilityFans)
+			{
+				renderer->SetRenderTarget(target);
+				renderer->SetScissorRect(lightRect);
+				renderer->SetBlendMode(Renderer::BlendMode::Additive);
+				DrawVisibilityLight(*lightSource, camera, target->GetSize(), m_fanRanges[i]);
+				restoreScissor();
+				continue;
+			}
 
+			if (shadowed && polarMap && m_polarRows[i] >= 0)
+			{
+				renderer->SetRenderTarget(target);
+				renderer->SetScissorRect(lightRect);
+				renderer->SetBlendMode(Renderer::BlendMode::Additive);
+				DrawPolarLight(renderer, *lightSource, camera, target->GetSize(), polarMap->GetTexture(), m_polarRows[i]);
+				restoreScissor();
+				continue;
+			}
 
-			if (enableShadows)
+			if (!shadowed || stencilShadows)
 			{
-				// Draw shadows
-				m_shadowShader.Use();
-				m_shadowShader.SetMat4("proj", camera.GetProjectionMatrix());
-				m_shadowShader.SetMat4("view", camera.GetViewMatrix());
+				renderer->SetRenderTarget(target);
+				renderer->SetScissorRect(lightRect);
 
-				m_shadowVertices.clear(); // clear previous shadow vertices
-				for (const auto& obstacle : m_obstacles)
+				if (shadowed)
 				{
-					if (!obstacle) continue; // skip null obstacles
-					std::vector<ShadowQuad> shadowQuads = lightSource->GetShadowQuads(*obstacle);
-					std::vector<glm::vec2> vertices = GetShadowTriangles(shadowQuads);
+					// write the shadows to the stencil buffer only
+					glStencilMask(0xFF);
+					glClear(GL_STENCIL_BUFFER_BIT);
+					glEnable(GL_STENCIL_TEST);
+					glStencilFunc(GL_ALWAYS, 1, 0xFF);
+					glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+					glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+					DrawShadows(*lightSource, i, camera, precomputed);
+
+					// the light is only added outside of them
+					glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+					glStencilFunc(GL_EQUAL, 0, 0xFF);
+					glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+				}
 
-					// add new vertices
-					if (m_shadowVertices.size() + vertices.size() > m_maxQuadCount * 6)
-						BatchShadows(); // flush previous batch if it exceeds max capacity
+				renderer->SetBlendMode(Renderer::BlendMode::Additive);
+				DrawLight(renderer, *lightSource, camera, target->GetSize());
 
-					m_shadowVertices.insert(m_shadowVertices.end(), vertices.begin(), vertices.end());
+				if (shadowed)
+					glDisable(GL_STENCIL_TEST);
 
-				}
+				restoreScissor();
+				continue;
+			}
 
-				BatchShadows(); // draw all accumulated shadows
+			if (!tempLightFBO)
+			{
+				// temporary light FBO, recycled by the renderer pool.
+				tempLightFBO = renderer->GetRenderTargetPool().Acquire(target->GetSize(), GL_RGB16F);
+				if (!tempLightFBO)
+				{
+					Utils::Logger::Error("LightSystem::RenderLightPasses : could not acquire the temporary light target.");
+					break;
+				}
 			}
 
+			renderer->SetBlendMode(Renderer::BlendMode::None);
+
+			renderer->SetRenderTarget(tempLightFBO);
+			renderer->SetScissorRect(lightRect);
+			renderer->Clear(Colors::Black); // clear the temporary light FBO
+
+			DrawLight(renderer, *lightSource, camera, target->GetSize());
+			DrawShadows(*lightSource, i, camera, precomputed);
+
 			// Add the temporary light FBO to the main target
 			renderer->SetBlendMode(Renderer::BlendMode::Additive);
 			renderer->SetRenderTarget(target);
 
-			renderer->BlitImage(m_tempLightFBO.GetTexture());
-
+			renderer->BlitImage(tempLightFBO->GetTexture());
+			restoreScissor();
 		}
 
-		renderer->SetBlendMode(Renderer::BlendMode::Alpha); // reset blend mode to default
-		renderer->SetRenderTarget(old); // reset to previous target
-		renderer->shader.Use();
+		if (tempLightFBO)
+			renderer->GetRenderTargetPool().Release(tempLightFBO);
+		if (polarMap)
+			renderer->GetRenderTargetPool().Release(polarMap);
+	}
 
+	void LightSystem::DrawLight(Renderer* renderer, const LightSource& light, const Camera& camera, const glm::ivec2& size)
+	{
+		// Set up light shader
+		m_lightShader.Use();
+		m_lightShader.SetMat4("uInvProj", glm::inverse(camera.GetProjectionMatrix()));
+		m_lightShader.SetMat4("uInvView", glm::inverse(camera.GetViewMatrix()));
+		m_lightShader.SetVec2("uScreenSize", size);
+		m_lightShader.SetVec2("uLightPos", light.position);
+		m_lightShader.SetVec3("uLightColor", light.color);
+		m_lightShader.SetFloat("uLightRadius", light.radius);
+		m_lightShader.SetFloat("uLightIntensity", light.intensity);
+		// Draw the light volume
+		renderer->FlushFullscreenQuad();
 	}
 
-	void LightSystem::RenderPrecomputedLighting(Renderer* renderer, RenderTarget* target, bool enableShadows, const Color& color)
+	void LightSystem::DrawShadows(const LightSource& light, size_t lightIndex, const Camera& camera, bool precomputed)
 	{
-		if (!m_initialized)
+		if (!precomputed)
 		{
-			Utils::Logger::Warning("LightSystem::RenderLighting : LightSystem not initialized.");
+			m_edgeShadowShader.Use();
+			m_edgeShadowShader.SetMat4("proj", camera.GetProjectionMatrix());
+			m_edgeShadowShader.SetMat4("view", camera.GetViewMatrix());
+			DrawExtrudedShadows(light);
 			return;
 		}
-		if (m_verticesLightBatches.size() != m_lightSources.size())
-		{
-			Utils::Logger::Warning("LightSystem::RenderLighting : Precomputed shadow vertices not initialized.");
+
+		// Draw shadows
+		m_shadowShader.Use();
+		m_shadowShader.SetMat4("proj", camera.GetProjectionMatrix());
+		m_shadowShader.SetMat4("view", camera.GetViewMatrix());
+
+		// the shadows of this light source are already on the GPU
+		const PrecomputedShadows& shadows = m_precomputedShadows[lightIndex];
+		if (!shadows.buffer || shadows.vertexCount == 0)
 			return;
+
+		glBindVertexArray(m_precomputedVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, shadows.buffer);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(shadows.vertexCount));
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void LightSystem::DrawExtrudedShadows(const LightSource& light)
+	{
+		UpdateEdgeBuffer();
+		if (m_edges.empty())
+			return;
+
+		m_edgeShadowShader.SetVec2("uLightPos", light.position);
+		m_edgeShadowShader.SetFloat("uLightRadius", light.radius);
+
+		// the edges of the obstacles in the radius, consecutive obstacles are drawn together.
+		m_queryObstacles.clear();
+		QueryObstacles({ light.position - light.radius, light.position + light.radius }, m_queryObstacles);
+		if (m_queryObstacles.empty())
+			return;
+
+		m_drawRanges.clear();
+		for (const Math::Polygon* obstacle : m_queryObstacles)
+		{
+			auto it = m_edgeRanges.find(obstacle);
+			if (it != m_edgeRanges.end() && it->second.y > 0)
+				m_drawRanges.push_back(it->second);
 		}
+		std::sort(m_drawRanges.begin(), m_drawRanges.end(), [](const glm::uvec2& a, const glm::uvec2& b) { return a.x < b.x; });
 
-		if (!renderer)
+		size_t count = 0;
+		for (const glm::uvec2& range : m_drawRanges)
 		{
-			Utils::Logger::Warning("LightSystem::RenderLighting : Renderer is null.");
-			return;
+			if (count > 0 && m_drawRanges[count - 1].x + m_drawRanges[count - 1].y == range.x)
+				m_drawRanges[count - 1].y += range.y;
+			else
+				m_drawRanges[count++] = range;
 		}
+		m_drawRanges.resize(count);
 
-		if (!target)
+		// too scattered: a single draw of every edge is cheaper, the shader skips the edges out of the radius.
+		const size_t maxDrawCount = 32;
+		if (m_drawRanges.size() > maxDrawCount)
+			m_drawRanges.assign(1, { 0, static_cast<unsigned int>(m_edges.size()) });
+
+		glBindVertexArray(m_edgeVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_edgeVBO);
+		for (const glm::uvec2& range : m_drawRanges)
 		{
-			Utils::Logger::Warning("LightSystem::RenderLighting : RenderTarget is null.");
+			// first instance of the range (no base instance before GL 4.2)
+			glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(range.x * sizeof(glm::vec4)));
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 9, static_cast<GLsizei>(range.y));
+		}
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void LightSystem::UpdateEdgeBuffer()
+	{
+		if (!m_edgeBufferDirty)
 			return;
+
+		m_edges.clear();
+		m_edgeRanges.clear();
+		for (const auto& obstacle : m_obstacles)
+		{
+			if (!obstacle) continue;
+
+			const std::vector<glm::vec2>& vertices = obstacle->vertices;
+			m_edgeRanges[obstacle.get()] = { static_cast<unsigned int>(m_edges.size()), static_cast<unsigned int>(vertices.size()) };
+			for (size_t i = 0; i < vertices.size(); i++)
+			{
+				const glm::vec2& next = vertices[(i + 1) % vertices.size()];
+				m_edges.push_back({ vertices[i], next });
+			}
 		}
 
-		// store previous renderTarget to restore it afterward.
-		RenderTarget* old = renderer->GetRenderTarget();
+		glBindBuffer(GL_ARRAY_BUFFER, m_edgeVBO);
+		if (m_edges.size() > m_edgeCapacity)
+		{
+			// grows geometrically, the obstacles are usually edited one by one
+			m_edgeCapacity = std::max(m_edges.size(), m_edgeCapacity * 2);
+			glBufferData(GL_ARRAY_BUFFER, m_edgeCapacity * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+		}
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_edges.size() * sizeof(glm::vec4), m_edges.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		m_edgeBufferDirty = false;
+	}
+
+	void LightSystem::PrepareVisibilityFans(const Camera& camera, const glm::ivec2& size)
+	{
+		glm::mat4 viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
 
-		// recreate the temp FBO for correct size.
-		if (m_tempLightFBO.GetSize() != target->GetSize())
+		m_selectedLights.assign(m_lightSources.size(), 0);
+		for (size_t i = 0; i < m_lightSources.size(); i++)
 		{
-			m_tempLightFBO.Cleanup(); // cleanup previous FBO if it exists
-			glm::ivec2 size = target->GetSize();
-			m_tempLightFBO.Create(size.x, size.y, GL_RGB16F);
+			const auto& lightSource = m_lightSources[i];
+			m_selectedLights[i] = lightSource && lightSource->castShadows && !IsTiled(*lightSource, true) &&
+				GetLightScreenRect(*lightSource, viewProjection, size).z != 0;
 		}
+		GatherLightObstacles();
 
+		// a slice per light: the center, the polygon and its first vertex again (triangle fan)
+		m_fanRanges.assign(m_lightSources.size(), { 0, 0 });
+		size_t capacity = 0;
+		for (size_t i = 0; i < m_lightSources.size(); i++)
+		{
+			if (!m_selectedLights[i])
+				continue;
 
-		renderer->SetRenderTarget(target);
+			glm::uvec2 obstacles = m_lightObstacleRanges[i];
+			m_fanRanges[i].x = static_cast<unsigned int>(capacity);
+			capacity += GetVisibilityCapacity(m_lightObstacles.data() + obstacles.x, obstacles.y) + 2;
+		}
+		if (capacity == 0)
+			return;
+		if (m_fanVertices.size() < capacity)
+			m_fanVertices.resize(capacity);
 
-		// clear target and set background lighting color
-		renderer->Clear(color);
+		// the sweeps run on the workers, each light writes its own slice.
+		m_workers.ParallelFor(m_lightSources.size(), [this](size_t begin, size_t end)
+		{
+			thread_local std::vector<Math::Edge> edges;
+			thread_local std::vector<float> angles;
+			thread_local std::vector<unsigned int> events;
+
+			for (size_t i = begin; i < end; i++)
+			{
+				if (!m_selectedLights[i])
+					continue;
+
+				const LightSource& light = *m_lightSources[i];
+				glm::uvec2 obstacles = m_lightObstacleRanges[i];
+				glm::vec2* fan = m_fanVertices.data() + m_fanRanges[i].x;
 
+				size_t count = SweepVisibility(light.position, light.radius, m_lightObstacles.data() + obstacles.x, obstacles.y, fan + 1, edges, angles, events);
+				if (count < 3)
+					continue;	// nothing lit
+
+				fan[0] = light.position;
+				fan[count + 1] = fan[1];
+				m_fanRanges[i].y = static_cast<unsigned int>(count + 2);
+			}
+		});
+
+		// orphans the previous storage
+		glBindBuffer(GL_ARRAY_BUFFER, m_fanVBO);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::vec2), m_fanVertices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void LightSystem::DrawVisibilityLight(const LightSource& light, const Camera& camera, const glm::ivec2& size, const glm::uvec2& fan)
+	{
+		if (fan.y == 0)
+			return;
+
+		m_visibilityLightShader.Use();
+		m_visibilityLightShader.SetMat4("proj", camera.GetProjectionMatrix());
+		m_visibilityLightShader.SetMat4("view", camera.GetViewMatrix());
+		m_visibilityLightShader.SetMat4("uInvProj", glm::inverse(camera.GetProjectionMatrix()));
+		m_visibilityLightShader.SetMat4("uInvView", glm::inverse(camera.GetViewMatrix()));
+		m_visibilityLightShader.SetVec2("uScreenSize", size);
+		m_visibilityLightShader.SetVec2("uLightPos", light.position);
+		m_visibilityLightShader.SetVec3("uLightColor", light.color);
+		m_visibilityLightShader.SetFloat("uLightRadius", light.radius);
+		m_visibilityLightShader.SetFloat("uLightIntensity", light.intensity);
+
+		glBindVertexArray(m_fanVAO);
+		glDrawArrays(GL_TRIANGLE_FAN, fan.x, fan.y);
+		glBindVertexArray(0);
+	}
+
+	void LightSystem::ComputeVisibilityPolygon(const glm::vec2& origin, float radius, Math::Polygon& polygon)
+	{
+		m_queryObstacles.clear();
+		QueryObstacles({ origin - radius, origin + radius }, m_queryObstacles);
+
+		polygon.vertices.resize(GetVisibilityCapacity(m_queryObstacles.data(), m_queryObstacles.size()));
+		size_t count = SweepVisibility(origin, radius, m_queryObstacles.data(), m_queryObstacles.size(), polygon.vertices.data(), m_visibilityEdges, m_visibilityAngles, m_visibilityEvents);
+		polygon.vertices.resize(count);
+	}
+
+	void LightSystem::GatherLightObstacles()
+	{
+		m_lightObstacles.clear();
+		m_lightObstacleRanges.assign(m_lightSources.size(), { 0, 0 });
+		for (size_t i = 0; i < m_lightSources.size(); i++)
+		{
+			if (!m_selectedLights[i])
+				continue;
+
+			const LightSource& light = *m_lightSources[i];
+			m_lightObstacleRanges[i].x = static_cast<unsigned int>(m_lightObstacles.size());
+			QueryObstacles({ light.position - light.radius, light.position + light.radius }, m_lightObstacles);
+			m_lightObstacleRanges[i].y = static_cast<unsigned int>(m_lightObstacles.size()) - m_lightObstacleRanges[i].x;
+		}
+	}
+
+	RenderTarget* LightSystem::RenderPolarShadowMap(Renderer* renderer, RenderTarget* target)
+	{
 		const Camera& camera = renderer->GetCamera();
+		glm::ivec2 size = target->GetSize();
+		glm::mat4 viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+
+		// a row per shadowed light on screen, limited by the texture height.
+		const int maxRows = 4096;
 
+		m_lightData.clear();
+		m_polarRows.assign(m_lightSources.size(), -1);
+		float maxRadius = 0.f;
 		for (size_t i = 0; i < m_lightSources.size(); i++)
 		{
 			const auto& lightSource = m_lightSources[i];
+			if (!lightSource || !lightSource->castShadows || IsTiled(*lightSource, true))
+				continue;
+			if (GetLightScreenRect(*lightSource, viewProjection, size).z == 0)
+				continue;	// off screen
+			if (m_lightData.size() / 2 >= maxRows)
+				break;		// the remaining lights keep the geometry shadows
+
+			m_polarRows[i] = static_cast<int>(m_lightData.size() / 2);
+			m_lightData.push_back({ lightSource->position, lightSource->radius, lightSource->intensity });
+			m_lightData.push_back({ lightSource->color, 0.f });
+			maxRadius = std::max(maxRadius, lightSource->radius);
+		}
 
-			if (!lightSource) continue; // skip null light sources
+		if (m_lightData.empty())
+			return nullptr;
 
-			renderer->SetBlendMode(Renderer::BlendMode::None);
+		RenderTargetPool& pool = renderer->GetRenderTargetPool();
 
-			renderer->SetRenderTarget(&m_tempLightFBO);
-			renderer->Clear(Colors::Black); // clear the temporary light FBO
+		// occlusion texture: the visible area extended by the radius of the lights, at the density of the target.
+		glm::vec4 visible = camera.GetVisibleBounds();
+		glm::vec4 rect = visible + glm::vec4(-maxRadius, -maxRadius, maxRadius, maxRadius);
+		glm::vec2 scale = (glm::vec2(rect.z, rect.w) - glm::vec2(rect)) / (glm::vec2(visible.z, visible.w) - glm::vec2(visible));
+		glm::ivec2 occlusionSize = glm::clamp(glm::ivec2(glm::ceil(glm::vec2(size) * scale / 64.f)) * 64, glm::ivec2(64), glm::ivec2(2048));
 
-			// Set up light shader
-			m_lightShader.Use();
-			m_lightShader.SetMat4("uInvProj", glm::inverse(camera.GetProjectionMatrix()));
-			m_lightShader.SetMat4("uInvView", glm::inverse(camera.GetViewMatrix()));
-			m_lightShader.SetVec2("uScreenSize", target->GetSize());
-			m_lightShader.SetVec2("uLightPos", lightSource->position);
-			m_lightShader.SetVec3("uLightColor", lightSource->color);
-			m_lightShader.SetFloat("uLightRadius", lightSource->radius);
-			m_lightShader.SetFloat("uLightIntensity", lightSource->intensity);
-			// Draw the light volume
-			renderer->FlushFullscreenQuad();
+		RenderTarget* occlusion = pool.Acquire(occlusionSize, GL_R8);
+		if (!occlusion)
+		{
+			Utils::Logger::Error("LightSystem::RenderPolarShadowMap : could not acquire the occlusion target.");
+			return nullptr;
+		}
 
+		renderer->SetRenderTarget(occlusion);
+		renderer->SetBlendMode(Renderer::BlendMode::None);
+		renderer->Clear(Colors::White);
 
-			if (enableShadows)
-			{
-				// Draw shadows
-				m_shadowShader.Use();
-				m_shadowShader.SetMat4("proj", camera.GetProjectionMatrix());
-				m_shadowShader.SetMat4("view", camera.GetViewMatrix());
+		m_shadowShader.Use();
+		m_shadowShader.SetMat4("proj", glm::ortho(rect.x, rect.z, rect.y, rect.w));
+		m_shadowShader.SetMat4("view", glm::mat4(1.f));
 
-				// render all batches for this light source
-				for (size_t j = 0; j < m_verticesLightBatches[i].size(); j++)
+		m_shadowVertices.clear();
+		m_queryObstacles.clear();
+		QueryObstacles({ { rect.x, rect.y }, { rect.z, rect.w } }, m_queryObstacles);
+		for (const Math::Polygon* obstacle : m_queryObstacles)
+		{
+			size_t start = m_shadowVertices.size();
+			obstacle->Triangulate(m_shadowVertices);
+			if (m_shadowVertices.size() > m_maxQuadCount * 6)
+			{
+				// flush the previous obstacles, then this one
+				std::vector<glm::vec2> vertices(m_shadowVertices.begin() + start, m_shadowVertices.end());
+				m_shadowVertices.resize(start);
+				BatchShadows();
+				for (size_t first = 0; first < vertices.size(); first += m_maxQuadCount * 6)
 				{
-					const auto& batch = m_verticesLightBatches[i][j];
+					size_t last = std::min(vertices.size(), first + m_maxQuadCount * 6);
+					m_shadowVertices.assign(vertices.begin() + first, vertices.begin() + last);
+					BatchShadows();
+				}
+			}
+		}
+		BatchShadows();
 
+		// polar map: a row per light (height rounded for the pool), a column per direction.
+		int rows = static_cast<int>(m_lightData.size() / 2);
+		RenderTarget* polarMap = pool.Acquire({ m_polarResolution, (rows + 15) / 16 * 16 }, GL_R32F);
+		if (!polarMap)
+		{
+			Utils::Logger::Error("LightSystem::RenderPolarShadowMap : could not acquire the polar map target.");
+			pool.Release(occlusion);
+			return nullptr;
+		}
 
-					BatchVertices(batch); // flush previous batch if it exceeds max capacity
+		glBindBuffer(GL_TEXTURE_BUFFER, m_lightDataBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, m_lightData.size() * sizeof(glm::vec4), m_lightData.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
+		renderer->SetRenderTarget(polarMap);
 
-				}
+		m_polarMapShader.Use();
+		m_polarMapShader.SetVec4("uOcclusionRect", rect);
+		m_polarMapShader.SetFloat("uResolution", static_cast<float>(m_polarResolution));
 
-			}
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, m_lightDataTexture);
+		occlusion->GetTexture().Bind(1);
 
-			// Add the temporary light FBO to the main target
-			renderer->SetBlendMode(Renderer::BlendMode::Additive);
-			renderer->SetRenderTarget(target);
+		renderer->FlushFullscreenQuad();
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
 
-			renderer->BlitImage(m_tempLightFBO.GetTexture());
+		pool.Release(occlusion);
+		return polarMap;
+	}
+
+	void LightSystem::DrawPolarLight(Renderer* renderer, const LightSource& light, const Camera& camera, const glm::ivec2& size, const Texture& polarMap, int row)
+	{
+		m_polarLightShader.Use();
+		m_polarLightShader.SetMat4("uInvProj", glm::inverse(camera.GetProjectionMatrix()));
+		m_polarLightShader.SetMat4("uInvView", glm::inverse(camera.GetViewMatrix()));
+		m_polarLightShader.SetVec2("uScreenSize", size);
+		m_polarLightShader.SetVec2("uLightPos", light.position);
+		m_polarLightShader.SetVec3("uLightColor", light.color);
+		m_polarLightShader.SetFloat("uLightRadius", light.radius);
+		m_polarLightShader.SetFloat("uLightIntensity", light.intensity);
+		m_polarLightShader.SetInt("uPolarRow", row);
+
+		polarMap.Bind(0);
+		renderer->FlushFullscreenQuad();
+	}
 
+	void LightSystem::SetShadowTechnique(ShadowTechnique technique, int polarResolution)
+	{
+		if (polarResolution <= 0)
+		{
+			Utils::Logger::Warning("LightSystem::SetShadowTechnique : polar resolution must be positive, using 512.");
+			polarResolution = 512;
 		}
 
-		renderer->SetBlendMode(Renderer::BlendMode::Alpha); // reset blend mode to default
-		renderer->SetRenderTarget(old); // reset to previous target
-		renderer->shader.Use();
+		m_shadowTechnique = technique;
+		m_polarResolution = polarResolution;
+	}
 
+	void LightSystem::SetTiledLighting(bool enabled, int tileSize)
+	{
+		if (tileSize <= 0)
+		{
+			Utils::Logger::Warning("LightSystem::SetTiledLighting : tile size must be positive, using 32.");
+			tileSize = 32;
+		}
+
+		m_tiledLighting = enabled;
+		m_tileSize = tileSize;
+	}
+
+	void LightSystem::RenderTiledLights(Renderer* renderer, RenderTarget* target, bool enableShadows)
+	{
+		const Camera& camera = renderer->GetCamera();
+		glm::ivec2 size = target->GetSize();
+
+		BinLights(camera, size, enableShadows);
+		if (m_tileLightIndices.empty())
+			return;	// no tiled light on screen
+
+		// upload the tables (orphaning the previous storage)
+		glBindBuffer(GL_TEXTURE_BUFFER, m_lightDataBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, m_lightData.size() * sizeof(glm::vec4), m_lightData.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_tileRangeBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, m_tileRanges.size() * sizeof(glm::uvec2), m_tileRanges.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, m_tileLightBuffer);
+		glBufferData(GL_TEXTURE_BUFFER, m_tileLightIndices.size() * sizeof(unsigned int), m_tileLightIndices.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		renderer->SetRenderTarget(target);
+		renderer->SetBlendMode(Renderer::BlendMode::Additive);
+
+		m_tiledLightShader.Use();
+		m_tiledLightShader.SetMat4("uInvProj", glm::inverse(camera.GetProjectionMatrix()));
+		m_tiledLightShader.SetMat4("uInvView", glm::inverse(camera.GetViewMatrix()));
+		m_tiledLightShader.SetVec2("uScreenSize", size);
+		m_tiledLightShader.SetInt("uTileSize", m_tileSize);
+		m_tiledLightShader.SetInt("uTileCountX", (size.x + m_tileSize - 1) / m_tileSize);
+
+		const GLuint textures[3] = { m_lightDataTexture, m_tileRangeTexture, m_tileLightTexture };
+		for (int i = 0; i < 3; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+		}
+
+		renderer->FlushFullscreenQuad();
+
+		for (int i = 0; i < 3; i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	void LightSystem::BinLights(const Camera& camera, const glm::ivec2& size, bool enableShadows)
+	{
+		glm::ivec2 tileCount = (size + m_tileSize - 1) / m_tileSize;
+		glm::mat4 viewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+
+		m_lightData.clear();
+		m_lightTiles.clear();
+		m_tileRanges.assign(static_cast<size_t>(tileCount.x) * tileCount.y, { 0, 0 });
+		m_tileLightIndices.clear();
+
+		// find the tiles of each light from its pixel rect.
+		for (const auto& lightSource : m_lightSources)
+		{
+			if (!lightSource || !IsTiled(*lightSource, enableShadows))
+				continue;
+
+			glm::ivec4 rect = GetLightScreenRect(*lightSource, viewProjection, size);
+			if (rect.z == 0)
+				continue;	// off screen
+
+			glm::ivec4 tiles{
+				rect.x / m_tileSize,
+				rect.y / m_tileSize,
+				(rect.x + rect.z - 1) / m_tileSize,
+				(rect.y + rect.w - 1) / m_tileSize
+			};
+
+			m_lightData.push_back({ lightSource->position, lightSource->radius, lightSource->intensity });
+			m_lightData.push_back({ lightSource->color, 0.f });
+			m_lightTiles.push_back(tiles);
+
+			for (int y = tiles.y; y <= tiles.w; y++)
+				for (int x = tiles.x; x <= tiles.z; x++)
+					m_tileRanges[y * tileCount.x + x].y++;
+		}
+
+		// the tiles get consecutive ranges of the index list (counting sort).
+		unsigned int first = 0;
+		for (glm::uvec2& range : m_tileRanges)
+		{
+			range.x = first;
+			first += range.y;
+			range.y = 0;	// counted again while filling
+		}
+		m_tileLightIndices.resize(first);
+
+		for (size_t light = 0; light < m_lightTiles.size(); light++)
+		{
+			const glm::ivec4& tiles = m_lightTiles[light];
+			for (int y = tiles.y; y <= tiles.w; y++)
+			{
+				for (int x = tiles.x; x <= tiles.z; x++)
+				{
+					glm::uvec2& range = m_tileRanges[y * tileCount.x + x];
+					m_tileLightIndices[range.x + range.y++] = static_cast<unsigned int>(light);
+				}
+			}
+		}
 	}
 
 	void LightSystem::PrecomputeShadowVertices()
+	{
+		m_precomputedShadowsDirty = true;
+		UpdatePrecomputedShadows();
+	}
+
+	void LightSystem::UpdatePrecomputedShadows()
 	{
 		if (!m_initialized)
 		{
-			Utils::Logger::Warning("LightSystem::PrecomputeShadowVertices : LightSystem not initialized.");
+			Utils::Logger::Warning("LightSystem::UpdatePrecomputedShadows : LightSystem not initialized.");
 			return;
 		}
-		m_verticesLightBatches.clear(); // clear previous batches
-		for (const auto& lightSource : m_lightSources)
+
+		m_precomputedShadows.resize(m_lightSources.size());
+
+		if (m_precomputedShadowsDirty)
 		{
-			std::vector<std::vector<glm::vec2>> batches;
-			std::vector<glm::vec2> batch;
-			if (!lightSource) continue; // skip null light sources
+			// convex obstacles cast a single silhouette quad, tested once for all the lights.
+			m_convexObstacles.clear();
 			for (const auto& obstacle : m_obstacles)
 			{
-				if (!obstacle) continue; // skip null obstacles
-				std::vector<ShadowQuad> shadowQuads = lightSource->GetShadowQuads(*obstacle);
-				std::vector<glm::vec2> vertices = GetShadowTriangles(shadowQuads);
-				// add new vertices
-				if (batch.size() + vertices.size() > m_maxQuadCount * 6)
+				if (obstacle)
+					m_convexObstacles[obstacle.get()] = obstacle->IsConvex();
+			}
+		}
+
+		// a light is dirty if it changed since its shadows were generated, or if an obstacle changed in its square.
+		m_selectedLights.assign(m_lightSources.size(), 0);
+		m_dirtyLights.clear();
+		for (size_t i = 0; i < m_lightSources.size(); i++)
+		{
+			const LightSource* light = m_lightSources[i].get();
+			if (!light)
+				continue;
+
+			const PrecomputedShadows& shadows = m_precomputedShadows[i];
+			bool dirty = m_precomputedShadowsDirty || shadows.radius < 0.f ||
+				shadows.position != light->position || shadows.radius != light->radius;
+
+			Math::AABB area = { light->position - light->radius, light->position + light->radius };
+			for (size_t b = 0; b < m_changedObstacleBounds.size() && !dirty; b++)
+				dirty = area.Intersects(m_changedObstacleBounds[b]);
+
+			if (dirty)
+			{
+				m_selectedLights[i] = 1;
+				m_dirtyLights.push_back(static_cast<unsigned int>(i));
+			}
+		}
+		m_changedObstacleBounds.clear();
+		m_precomputedShadowsDirty = false;
+
+		// one vertex vector per dirty light, the ones of the lights which stopped changing are released.
+		m_dirtyShadowVertices.resize(m_dirtyLights.size());
+
+		if (m_dirtyLights.empty())
+			return;
+
+		// only the obstacles in the radius of each light
+		GatherLightObstacles();
+
+		// each worker generates the shadows of its dirty lights, the vectors keep their capacity between updates.
+		m_workers.ParallelFor(m_dirtyLights.size(), [this](size_t begin, size_t end)
+		{
+			for (size_t d = begin; d < end; d++)
+			{
+				unsigned int i = m_dirtyLights[d];
+				const LightSource& light = *m_lightSources[i];
+				PrecomputedShadows& shadows = m_precomputedShadows[i];
+
+				// same triangles as GetShadowTriangles
+				std::vector<glm::vec2>& out = m_dirtyShadowVertices[d];
+				out.clear();
+				auto writeQuad = [&out](const ShadowQuad& quad)
 				{
-					// add current batch to the list and start a new one
-					batches.push_back(batch);
-					batch.clear();
-				}
-				batch.insert(batch.end(), vertices.begin(), vertices.end());
+					out.insert(out.end(), { quad.p1, quad.p2, quad.p3, quad.p1, quad.p3, quad.p4 });
+				};
+
+				glm::uvec2 obstacles = m_lightObstacleRanges[i];
+				for (unsigned int o = obstacles.x; o < obstacles.x + obstacles.y; o++)
+					EmitShadowQuads(light, *m_lightObstacles[o], m_convexObstacles.at(m_lightObstacles[o]), writeQuad);
+
+				shadows.position = light.position;
+				shadows.radius = light.radius;
 			}
-			// add the last batch if not empty
-			if (!batch.empty())
+		});
+
+		// upload the new shadows, static lights are not uploaded again
+		for (size_t d = 0; d < m_dirtyLights.size(); d++)
+		{
+			PrecomputedShadows& shadows = m_precomputedShadows[m_dirtyLights[d]];
+			const std::vector<glm::vec2>& vertices = m_dirtyShadowVertices[d];
+			if (!shadows.buffer)
+				glGenBuffers(1, &shadows.buffer);
+
+			glBindBuffer(GL_ARRAY_BUFFER, shadows.buffer);
+			if (vertices.size() > shadows.capacity)
 			{
-				batches.push_back(batch);
-				batch.clear();
+				// grows geometrically, a moving light changes its vertex count every frame
+				shadows.capacity = std::max(vertices.size(), shadows.capacity * 2);
+				glBufferData(GL_ARRAY_BUFFER, shadows.capacity * sizeof(glm::vec2), nullptr, GL_DYNAMIC_DRAW);
 			}
+			glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(glm::vec2), vertices.data());
+			shadows.vertexCount = vertices.size();
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 
-			// add the batches for this light source
-			m_verticesLightBatches.push_back(batches);
+	void LightSystem::ReleasePrecomputedShadows()
+	{
+		for (PrecomputedShadows& shadows : m_precomputedShadows)
+		{
+			if (shadows.buffer)
+				glDeleteBuffers(1, &shadows.buffer);
 		}
-		
+		m_precomputedShadows.clear();
+		m_dirtyShadowVertices.clear();
 	}
 
-	void LightSystem::BatchVertices(const std::vector<glm::vec2>& vertices)
+	void LightSystem::BatchVertices(const glm::vec2* vertices, size_t count)
 	{
 		glBindVertexArray(shadowVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, shadowVBO);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::vec2) * vertices.size(), vertices.data());
-		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size()));
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::vec2) * count, vertices);
+		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(count));
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -451,16 +1630,24 @@ namespace LittleEngine::Graphics
 	{
 		LightSource l = { pos, color, intensity, radius };
 		m_lightSources.push_back(std::make_unique<LightSource>(l));
+		m_precomputedShadows.emplace_back();
 		return m_lightSources.back().get();
 	}
 
 	bool LightSystem::DeleteLightSource(LightSource* lightSource)
 	{
-		auto it = std::remove_if(m_lightSources.begin(), m_lightSources.end(),
+		auto it = std::find_if(m_lightSources.begin(), m_lightSources.end(),
 			[lightSource](const std::unique_ptr<LightSource>& ls) { return ls.get() == lightSource; });
 		if (it != m_lightSources.end())	// found
 		{
-			m_lightSources.erase(it, m_lightSources.end());
+			size_t index = it - m_lightSources.begin();
+			if (index < m_precomputedShadows.size())
+			{
+				if (m_precomputedShadows[index].buffer)
+					glDeleteBuffers(1, &m_precomputedShadows[index].buffer);
+				m_precomputedShadows.erase(m_precomputedShadows.begin() + index);
+			}
+			m_lightSources.erase(it);
 			return true;
 		}
 		return false;
@@ -478,16 +1665,29 @@ namespace LittleEngine::Graphics
 		}
 
 		m_obstacles.push_back(std::make_unique<Math::Polygon>(poly));
+		m_obstacleGrid.Insert(m_obstacles.back().get(), poly.GetBounds());
+		m_convexObstacles[m_obstacles.back().get()] = poly.IsConvex();
+		RecordObstacleChange(poly.GetBounds());
+		m_edgeBufferDirty = true;
 		return m_obstacles.back().get();
 	}
 
 	bool LightSystem::DeleteObstacle(Math::Polygon* polygon)
 	{
-		auto it = std::remove_if(m_obstacles.begin(), m_obstacles.end(),
+		// the shadows were cast from the bounds the obstacle was last inserted or updated with.
+		const Math::AABB* gridBounds = m_obstacleGrid.GetBounds(polygon);
+		bool inGrid = gridBounds != nullptr;
+		Math::AABB oldBounds = inGrid ? *gridBounds : Math::AABB{};
+		m_obstacleGrid.Remove(polygon);
+
+		auto it = std::find_if(m_obstacles.begin(), m_obstacles.end(),
 			[polygon](const std::unique_ptr<Math::Polygon>& p) { return p.get() == polygon; });
 		if (it != m_obstacles.end())	// found
 		{
-			m_obstacles.erase(it, m_obstacles.end());
+			RecordObstacleChange(inGrid ? oldBounds : polygon->GetBounds());
+			m_convexObstacles.erase(polygon);
+			m_obstacles.erase(it);
+			m_edgeBufferDirty = true;
 			return true;
 		}
 		//  not found
@@ -497,6 +1697,65 @@ namespace LittleEngine::Graphics
 		
 	}
 
+	void LightSystem::UpdateObstacle(Math::Polygon* polygon)
+	{
+		const Math::AABB* oldBounds = m_obstacleGrid.GetBounds(polygon);
+		if (!oldBounds)
+		{
+			Utils::Logger::Warning("LightSystem::UpdateObstacle : Polygon not found.");
+			return;
+		}
+
+		// the lights around both positions of the obstacle need their shadows again
+		RecordObstacleChange(*oldBounds);
+		RecordObstacleChange(polygon->GetBounds());
+
+		m_obstacleGrid.Update(polygon, polygon->GetBounds());
+		m_convexObstacles[polygon] = polygon->IsConvex();
+		m_edgeBufferDirty = true;
+	}
+
+	void LightSystem::RecordObstacleChange(const Math::AABB& bounds)
+	{
+		// everything is generated again anyway (or nothing was generated yet, RenderLighting only).
+		if (m_precomputedShadowsDirty)
+			return;
+
+		// many changes between two updates: testing every light against them costs more than a full update.
+		const size_t maxChangeCount = 64;
+		if (m_changedObstacleBounds.size() >= maxChangeCount)
+		{
+			m_changedObstacleBounds.clear();
+			m_precomputedShadowsDirty = true;
+			return;
+		}
+
+		m_changedObstacleBounds.push_back(bounds);
+	}
+
+	void LightSystem::MarkObstaclesDirty()
+	{
+		m_edgeBufferDirty = true;
+		m_obstacleGridDirty = true;
+		m_precomputedShadowsDirty = true;
+	}
+
+	void LightSystem::QueryObstacles(const Math::AABB& area, std::vector<Math::Polygon*>& obstacles)
+	{
+		if (m_obstacleGridDirty)
+		{
+			m_obstacleGrid.Clear();
+			for (const auto& obstacle : m_obstacles)
+			{
+				if (obstacle)
+					m_obstacleGrid.Insert(obstacle.get(), obstacle->GetBounds());
+			}
+			m_obstacleGridDirty = false;
+		}
+
+		m_obstacleGrid.Query(area, obstacles);
+	}
+
 
 #pragma endregion
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "LittleEngine/Graphics/post_process_stack.h"
+
+#include "LittleEngine/Utils/logger.h"
+
+#include <algorithm>
+#include <sstream>
+
+
+namespace LittleEngine::Graphics
+{
+
+	// declarations shared by all the generated shaders, unused uniforms are removed by the compiler.
+	const std::string postProcessHeader = R"(
+		#version 330 core
+		in vec2 TexCoords;
+		out vec4 FragColor;
+
+		uniform sampler2D uTexture;
+		uniform sampler2D uLightTexture;
+
+		uniform float uExposure;
+		uniform float uContrast;
+		uniform float uBrightness;
+		uniform float uSaturation;
+		uniform vec3 uTint;
+		uniform float uVignetteIntensity;
+		uniform float uVignetteRadius;
+		uniform float uVignetteSoftness;
+		uniform float uSharpness;
+
+		void main()
+		{
+    )";
+
+	// first stage of a pass: reads the input.
+	const std::string sampleStage = R"(
+			vec4 color = texture(uTexture, TexCoords);
+    )";
+
+	const std::string sharpenStage = R"(
+			vec4 color;
+			{
+				vec2 texel = 1.0 / vec2(textureSize(uTexture, 0));
+
+				vec4 center = texture(uTexture, TexCoords);
+				vec3 north = texture(uTexture, TexCoords + vec2(0.0, texel.y)).rgb;
+				vec3 south = texture(uTexture, TexCoords - vec2(0.0, texel.y)).rgb;
+				vec3 east = texture(uTexture, TexCoords + vec2(texel.x, 0.0)).rgb;
+				vec3 west = texture(uTexture, TexCoords - vec2(texel.x, 0.0)).rgb;
+
+				// unsharp mask, clamped to the neighbourhood to avoid halos.
+				vec3 blur = (north + south + east + west) * 0.25;
+				vec3 sharpened = center.rgb + (center.rgb - blur) * uSharpness;
+
+				vec3 minColor = min(center.rgb, min(min(north, south), min(east, west)));
+				vec3 maxColor = max(center.rgb, max(max(north, south), max(east, west)));
+
+				color = vec4(clamp(sharpened, minColor, maxColor), center.a);
+			}
+    )";
+
+	const std::string lightMergeStage = R"(
+			color = vec4(color.rgb * texture(uLightTexture, TexCoords).rgb, 1.0);
+    )";
+
+	const std::string toneMapStage = R"(
+			color.rgb = vec3(1.0) - exp(-color.rgb * uExposure);
+    )";
+
+	const std::string colorGradeStage = R"(
+			color.rgb = (color.rgb - 0.5) * uContrast + 0.5 + uBrightness;
+			color.rgb = mix(vec3(dot(color.rgb, vec3(0.2126, 0.7152, 0.0722))), color.rgb, uSaturation);
+			color.rgb = max(color.rgb * uTint, 0.0);
+    )";
+
+	const std::string vignetteStage = R"(
+			{
+				float dist = length(TexCoords - 0.5) * 1.41421356;	// 1 at the corners
+				float vignette = 1.0 - smoothstep(uVignetteRadius - uVignetteSoftness, uVignetteRadius, dist);
+				color.rgb *= mix(1.0, vignette, uVignetteIntensity);
+			}
+    )";
+
+	const std::string postProcessFooter = R"(
+			FragColor = color;
+		}
+    )";
+
+
+#pragma region Initialization
+
+	void PostProcessStack::Initialize(const std::vector<PostProcessStage>& stages, const PostProcessSettings& settings)
+	{
+		if (m_initialized)
+			Shutdown();
+
+		m_settings = settings;
+
+		if (stages.empty())
+		{
+			Utils::Logger::Warning("PostProcessStack::Initialize : no stage, Apply will only copy the scene");
+		}
+
+		// split the stages into passes, a stage reading neighbouring pixels needs the previous stages written to a texture.
+		std::vector<std::vector<PostProcessStage>> groups(1);
+		for (PostProcessStage stage : stages)
+		{
+			if (ReadsNeighbours(stage) && !groups.back().empty())
+				groups.emplace_back();
+
+			groups.back().push_back(stage);
+		}
+
+		m_passes.resize(groups.size());		// shaders are created in place, Shader must not be copied once created
+		for (size_t i = 0; i < groups.size(); i++)
+		{
+			Pass& pass = m_passes[i];
+			pass.stages = groups[i];
+			pass.source = GenerateFragmentShader(pass.stages);
+			pass.usesLight = std::find(pass.stages.begin(), pass.stages.end(), PostProcessStage::LightMerge) != pass.stages.end();
+
+			pass.shader.Create(Renderer::GetFullscreenVertexShader(), pass.source, false);
+			pass.shader.Use();
+			pass.shader.SetInt("uTexture", 0);
+			pass.shader.SetInt("uLightTexture", 1);
+		}
+
+		m_initialized = true;
+	}
+
+	void PostProcessStack::Shutdown()
+	{
+		if (!m_initialized)
+			return;
+
+		for (Pass& pass : m_passes)
+		{
+			pass.shader.Cleanup();
+		}
+		m_passes.clear();
+
+		m_initialized = false;
+	}
+
+#pragma endregion
+
+	void PostProcessStack::Apply(Renderer* renderer, const Texture& scene, const Texture& light)
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("PostProcessStack::Apply : not initialized");
+			return;
+		}
+
+		if (scene.id == 0)
+			return;
+
+		for (const Pass& pass : m_passes)
+		{
+			if (pass.usesLight && light.id == 0)
+			{
+				Utils::Logger::Warning("PostProcessStack::Apply : the chain has a LightMerge stage but no light texture");
+				return;
+			}
+		}
+
+		RenderTarget* output = renderer->GetRenderTarget();
+		Renderer::BlendMode blendMode = renderer->GetBlendMode();
+		RenderTargetPool& pool = renderer->GetRenderTargetPool();
+
+		Texture input = scene;
+		RenderTarget* intermediate = nullptr;	// target read by the current pass
+
+		for (size_t i = 0; i < m_passes.size(); i++)
+		{
+			Pass& pass = m_passes[i];
+			bool last = i + 1 == m_passes.size();
+
+			RenderTarget* target = output;
+			if (!last)
+			{
+				// intermediate passes keep the scene resolution, HDR values survive until the tone mapping.
+				target = pool.Acquire({ scene.width, scene.height }, GL_RGBA16F);
+				if (!target)
+				{
+					Utils::Logger::Error("PostProcessStack::Apply : failed to create an intermediate target");
+					break;
+				}
+			}
+
+			renderer->SetRenderTarget(target);
+			if (!last)
+				glDisable(GL_BLEND);	// the intermediate target is fully overwritten
+			else
+				renderer->SetBlendMode(blendMode);
+
+			pass.shader.Use();
+			SetUniforms(pass.shader);
+			input.Bind(0);
+			if (pass.usesLight)
+				light.Bind(1);
+
+			renderer->FlushFullscreenQuad();
+
+			if (intermediate)
+				pool.Release(intermediate);
+
+			intermediate = last ? nullptr : target;
+			if (intermediate)
+				input = intermediate->GetTexture();
+		}
+
+		if (intermediate)	// only if a pass failed
+			pool.Release(intermediate);
+
+		glActiveTexture(GL_TEXTURE0);
+		renderer->SetRenderTarget(output);
+		renderer->SetBlendMode(blendMode);
+		renderer->shader.Use();	// reset to the default shader
+	}
+
+	std::string PostProcessStack::GenerateFragmentShader(const std::vector<PostProcessStage>& stages)
+	{
+		std::ostringstream code;
+		code << postProcessHeader;
+
+		size_t first = 0;
+		if (!stages.empty() && ReadsNeighbours(stages[0]))
+		{
+			code << sharpenStage;
+			first = 1;
+		}
+		else
+		{
+			code << sampleStage;
+		}
+
+		for (size_t i = first; i < stages.size(); i++)
+		{
+			switch (stages[i])
+			{
+			case PostProcessStage::LightMerge:	code << lightMergeStage;	break;
+			case PostProcessStage::ToneMap:		code << toneMapStage;		break;
+			case PostProcessStage::ColorGrade:	code << colorGradeStage;	break;
+			case PostProcessStage::Vignette:	code << vignetteStage;		break;
+			default:
+				break;	// neighbourhood stages always start a pass
+			}
+		}
+
+		code << postProcessFooter;
+		return code.str();
+	}
+
+	void PostProcessStack::SetUniforms(const Shader& shader) const
+	{
+		shader.SetFloat("uExposure", m_settings.exposure);
+		shader.SetFloat("uContrast", m_settings.contrast);
+		shader.SetFloat("uBrightness", m_settings.brightness);
+		shader.SetFloat("uSaturation", m_settings.saturation);
+		shader.SetVec3("uTint", m_settings.tint);
+		shader.SetFloat("uVignetteIntensity", m_settings.vignetteIntensity);
+		shader.SetFloat("uVignetteRadius", m_settings.vignetteRadius);
+		shader.SetFloat("uVignetteSoftness", m_settings.vignetteSoftness);
+		shader.SetFloat("uSharpness", m_settings.sharpness);
+	}
+
+}
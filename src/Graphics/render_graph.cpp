@@ -0,0 +1,376 @@
+#include "LittleEngine/Graphics/render_graph.h"
+
+#include "LittleEngine/Utils/logger.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+
+namespace LittleEngine::Graphics
+{
+
+#pragma region Initialization / lifetime management.
+
+	void RenderGraph::Initialize(Renderer* renderer)
+	{
+		if (m_initialized)
+		{
+			Utils::Logger::Warning("RenderGraph::Initialize : RenderGraph already initialized.");
+			return;
+		}
+		if (!renderer)
+		{
+			Utils::Logger::Error("RenderGraph::Initialize : Renderer is null.");
+			return;
+		}
+
+		m_renderer = renderer;
+		m_initialized = true;
+	}
+
+	void RenderGraph::Shutdown()
+	{
+		if (!m_initialized)
+			return;
+
+		Reset();
+
+		ReleasePhysicalTargets();
+
+		m_renderer = nullptr;
+		m_initialized = false;
+	}
+
+	void RenderGraph::Reset()
+	{
+		m_resources.clear();
+		m_passes.clear();
+		m_executionOrder.clear();
+		m_compiled = false;
+	}
+
+	void RenderGraph::ReleasePhysicalTargets()
+	{
+		if (m_renderer)
+		{
+			for (auto& physical : m_physicalTargets)
+				m_renderer->GetRenderTargetPool().Release(physical.target);
+		}
+		m_physicalTargets.clear();
+	}
+
+#pragma endregion
+
+
+#pragma region Resources
+
+	RenderGraphHandle RenderGraph::CreateTarget(const std::string& name, const glm::ivec2& size, GLenum internalFormat)
+	{
+		if (size.x <= 0 || size.y <= 0)
+		{
+			Utils::Logger::Error("RenderGraph::CreateTarget : size of '" + name + "' must be > 0 but was: (" + std::to_string(size.x) + ", " + std::to_string(size.y) + ")");
+			return InvalidRenderGraphHandle;
+		}
+
+		Resource resource;
+		resource.name = name;
+		resource.size = size;
+		resource.format = internalFormat;
+		m_resources.push_back(resource);
+		m_compiled = false;
+
+		return static_cast<RenderGraphHandle>(m_resources.size() - 1);
+	}
+
+	RenderGraphHandle RenderGraph::ImportTarget(const std::string& name, RenderTarget* target)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.imported = target;
+		resource.isImported = true;
+		resource.isOutput = true;
+		if (target)
+			resource.size = target->GetSize();
+		m_resources.push_back(resource);
+		m_compiled = false;
+
+		return static_cast<RenderGraphHandle>(m_resources.size() - 1);
+	}
+
+	void RenderGraph::MarkOutput(RenderGraphHandle handle)
+	{
+		if (!IsValid(handle))
+		{
+			Utils::Logger::Warning("RenderGraph::MarkOutput : invalid handle.");
+			return;
+		}
+		m_resources[handle].isOutput = true;
+		m_compiled = false;
+	}
+
+	RenderTarget* RenderGraph::GetTarget(RenderGraphHandle handle)
+	{
+		if (!IsValid(handle))
+		{
+			Utils::Logger::Error("RenderGraph::GetTarget : invalid handle.");
+			return nullptr;
+		}
+
+		const Resource& resource = m_resources[handle];
+		if (resource.isImported)
+			return resource.imported;
+
+		if (resource.physical < 0)
+		{
+			Utils::Logger::Error("RenderGraph::GetTarget : '" + resource.name + "' is not used by any executed pass.");
+			return nullptr;
+		}
+		return m_physicalTargets[resource.physical].target;
+	}
+
+	const Texture& RenderGraph::GetTexture(RenderGraphHandle handle)
+	{
+		static const Texture emptyTexture = {};
+
+		RenderTarget* target = GetTarget(handle);
+		if (!target)
+		{
+			Utils::Logger::Error("RenderGraph::GetTexture : resource has no texture (screen or unused target).");
+			return emptyTexture;
+		}
+		return target->GetTexture();
+	}
+
+#pragma endregion
+
+
+#pragma region Passes
+
+	void RenderGraph::AddPass(const std::string& name, const std::vector<RenderGraphHandle>& inputs, RenderGraphHandle output,
+		LoadOp loadOp, const ExecuteFunction& execute, const Color& clearColor)
+	{
+		if (!IsValid(output))
+		{
+			Utils::Logger::Error("RenderGraph::AddPass : pass '" + name + "' has an invalid output.");
+			return;
+		}
+
+		for (RenderGraphHandle input : inputs)
+		{
+			if (!IsValid(input))
+			{
+				Utils::Logger::Error("RenderGraph::AddPass : pass '" + name + "' has an invalid input.");
+				return;
+			}
+			if (input == output)
+			{
+				Utils::Logger::Error("RenderGraph::AddPass : pass '" + name + "' reads the target it renders to.");
+				return;
+			}
+			if (m_resources[input].isImported && m_resources[input].imported == nullptr)
+			{
+				Utils::Logger::Error("RenderGraph::AddPass : pass '" + name + "' cannot read the screen.");
+				return;
+			}
+		}
+
+		Pass pass;
+		pass.name = name;
+		pass.inputs = inputs;
+		pass.output = output;
+		pass.loadOp = loadOp;
+		pass.clearColor = clearColor;
+		pass.execute = execute;
+		m_passes.push_back(pass);
+		m_compiled = false;
+	}
+
+#pragma endregion
+
+
+	bool RenderGraph::Compile()
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("RenderGraph::Compile : RenderGraph not initialized.");
+			return false;
+		}
+
+		m_executionOrder.clear();
+		m_stats = {};
+		m_stats.passCount = static_cast<int>(m_passes.size());
+
+		// CULLING
+		// walk the passes backward keeping track of the resources whose current content is still needed.
+		// a pass is kept if its output is needed, then its inputs become needed. A pass which does not load
+		// its output overwrites it, so the previous writers of that output are not needed anymore.
+		std::unordered_set<RenderGraphHandle> needed;
+		for (size_t i = 0; i < m_resources.size(); i++)
+		{
+			if (m_resources[i].isOutput)
+				needed.insert(static_cast<RenderGraphHandle>(i));
+		}
+
+		std::vector<bool> kept(m_passes.size(), false);
+		for (int i = static_cast<int>(m_passes.size()) - 1; i >= 0; i--)
+		{
+			const Pass& pass = m_passes[i];
+			if (needed.count(pass.output) == 0)
+				continue;
+
+			kept[i] = true;
+			if (pass.loadOp != LoadOp::Load)
+				needed.erase(pass.output);
+			needed.insert(pass.inputs.begin(), pass.inputs.end());
+		}
+
+		for (size_t i = 0; i < m_passes.size(); i++)
+		{
+			if (kept[i])
+				m_executionOrder.push_back(static_cast<int>(i));
+		}
+		m_stats.culledPassCount = m_stats.passCount - static_cast<int>(m_executionOrder.size());
+
+		// LIFETIMES
+		for (auto& resource : m_resources)
+		{
+			resource.firstUse = -1;
+			resource.lastUse = -1;
+			resource.physical = -1;
+		}
+
+		auto use = [this](RenderGraphHandle handle, int index)
+		{
+			Resource& resource = m_resources[handle];
+			if (resource.firstUse < 0)
+				resource.firstUse = index;
+			resource.lastUse = index;
+		};
+
+		for (int i = 0; i < static_cast<int>(m_executionOrder.size()); i++)
+		{
+			const Pass& pass = m_passes[m_executionOrder[i]];
+			for (RenderGraphHandle input : pass.inputs)
+			{
+				if (!m_resources[input].isImported && m_resources[input].firstUse < 0)
+					Utils::Logger::Warning("RenderGraph::Compile : pass '" + pass.name + "' reads '" + m_resources[input].name + "' before it is written.");
+				use(input, i);
+			}
+			use(pass.output, i);
+
+			if (pass.loadOp == LoadOp::Load && !m_resources[pass.output].isImported && m_resources[pass.output].firstUse == i)
+				Utils::Logger::Warning("RenderGraph::Compile : pass '" + pass.name + "' loads '" + m_resources[pass.output].name + "' at its first use, it is cleared instead.");
+		}
+
+		// ALIASING
+		// transients are assigned in order of first use, a physical target can be reused
+		// once the last pass using its previous resource has executed.
+		std::vector<RenderGraphHandle> transients;
+		for (size_t i = 0; i < m_resources.size(); i++)
+		{
+			if (!m_resources[i].isImported && m_resources[i].firstUse >= 0)
+				transients.push_back(static_cast<RenderGraphHandle>(i));
+		}
+		std::stable_sort(transients.begin(), transients.end(), [this](RenderGraphHandle a, RenderGraphHandle b) {
+			return m_resources[a].firstUse < m_resources[b].firstUse;
+		});
+
+		// the targets of the previous compilation go back to the pool, an unchanged graph gets them back.
+		ReleasePhysicalTargets();
+
+		RenderTargetPool& pool = m_renderer->GetRenderTargetPool();
+		for (RenderGraphHandle handle : transients)
+		{
+			Resource& resource = m_resources[handle];
+
+			for (size_t i = 0; i < m_physicalTargets.size(); i++)
+			{
+				PhysicalTarget& physical = m_physicalTargets[i];
+				if (physical.size == resource.size && physical.format == resource.format && physical.busyUntil < resource.firstUse)
+				{
+					resource.physical = static_cast<int>(i);
+					break;
+				}
+			}
+
+			if (resource.physical < 0)
+			{
+				PhysicalTarget physical;
+				physical.target = pool.Acquire(resource.size, resource.format);
+				if (!physical.target)
+				{
+					Utils::Logger::Error("RenderGraph::Compile : failed to acquire the target for '" + resource.name + "'.");
+					return false;
+				}
+				physical.size = resource.size;
+				physical.format = resource.format;
+				m_physicalTargets.push_back(physical);
+				resource.physical = static_cast<int>(m_physicalTargets.size() - 1);
+			}
+
+			m_physicalTargets[resource.physical].busyUntil = resource.lastUse;
+
+			m_stats.unaliasedMemory += RenderTarget::GetMemoryUsage(resource.size, resource.format);
+		}
+
+		m_stats.transientCount = static_cast<int>(transients.size());
+		m_stats.physicalTargetCount = static_cast<int>(m_physicalTargets.size());
+		for (const auto& physical : m_physicalTargets)
+			m_stats.transientMemory += physical.target->GetMemoryUsage();
+
+		m_compiled = true;
+		return true;
+	}
+
+	void RenderGraph::Execute()
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("RenderGraph::Execute : RenderGraph not initialized.");
+			return;
+		}
+
+		if (!m_compiled && !Compile())
+			return;
+
+		m_stats.skippedBinds = 0;
+		m_stats.skippedClears = 0;
+
+		// store previous state to restore it afterward.
+		RenderTarget* old = m_renderer->GetRenderTarget();
+		Renderer::BlendMode oldBlendMode = m_renderer->GetBlendMode();
+
+		for (int i = 0; i < static_cast<int>(m_executionOrder.size()); i++)
+		{
+			Pass& pass = m_passes[m_executionOrder[i]];
+			const Resource& output = m_resources[pass.output];
+			RenderTarget* target = GetTarget(pass.output);
+
+			if (!output.isImported && target == nullptr)
+				continue;	// creation failed, already logged
+
+			if (m_renderer->GetRenderTarget() == target)
+				m_stats.skippedBinds++;
+			else
+				m_renderer->SetRenderTarget(target);
+
+			// the content of an aliased target is undefined at its first use (the image of a previous pass),
+			// a pass accumulating into it starts from the clear color.
+			LoadOp loadOp = pass.loadOp;
+			if (loadOp == LoadOp::Load && !output.isImported && output.firstUse == i)
+				loadOp = LoadOp::Clear;
+
+			if (loadOp == LoadOp::Clear)
+				m_renderer->Clear(pass.clearColor);
+			else if (loadOp == LoadOp::DontCare)
+				m_stats.skippedClears++;
+
+			if (pass.execute)
+				pass.execute(m_renderer, *this);
+		}
+
+		m_renderer->SetBlendMode(oldBlendMode);
+		m_renderer->SetRenderTarget(old);	// flushes the last pass
+	}
+
+}
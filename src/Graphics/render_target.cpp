@@ -7,7 +7,7 @@ namespace LittleEngine::Graphics
 
 #pragma region Initialization / lifetime management.
 
-	bool RenderTarget::Create(int width, int height, GLenum internalFormat)
+	bool RenderTarget::Create(int width, int height, GLenum internalFormat, bool depthStencil)
 	{
 		if (width < 0 || height < 0)
 		{
@@ -16,6 +16,7 @@ namespace LittleEngine::Graphics
 		}
 		m_width = width;
 		m_height = height;
+		m_format = internalFormat;
 
 		glGenFramebuffers(1, &m_fbo);
 		Bind();
@@ -32,7 +33,15 @@ namespace LittleEngine::Graphics
 		// bind the texture to the frame buffer.
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture.id, 0);
 
-		// attach depth, stencil buffer ? TODO
+		// attach depth / stencil buffer (never sampled, so a renderbuffer is enough).
+		if (depthStencil)
+		{
+			glGenRenderbuffers(1, &m_depthStencil);
+			glBindRenderbuffer(GL_RENDERBUFFER, m_depthStencil);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthStencil);
+		}
 
 		bool success = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;		// true if success
 
@@ -44,12 +53,37 @@ namespace LittleEngine::Graphics
 	void RenderTarget::Cleanup()
 	{
 		glDeleteFramebuffers(1, &m_fbo);
+		if (m_depthStencil != 0)
+			glDeleteRenderbuffers(1, &m_depthStencil);
+		m_depthStencil = 0;
 		m_texture.Cleanup();
 		m_width = -1;
 		m_height = -1;
 		m_fbo = -1;
 	}
 
+	size_t RenderTarget::GetMemoryUsage(const glm::ivec2& size, GLenum internalFormat)
+	{
+		if (size.x <= 0 || size.y <= 0)
+			return 0;
+
+		// approximate size of a pixel in video memory.
+		size_t bytesPerPixel = 4;	// GL_RGB / GL_RGBA (8 bits per channel, RGB is usually padded), GL_DEPTH24_STENCIL8
+		switch (internalFormat)
+		{
+		case GL_R8:			bytesPerPixel = 1; break;
+		case GL_R16F:		bytesPerPixel = 2; break;
+		case GL_RG16F:		bytesPerPixel = 4; break;
+		case GL_R32F:		bytesPerPixel = 4; break;
+		case GL_RGB16F:		bytesPerPixel = 8; break;
+		case GL_RGBA16F:	bytesPerPixel = 8; break;
+		case GL_RGB32F:		bytesPerPixel = 16; break;
+		case GL_RGBA32F:	bytesPerPixel = 16; break;
+		}
+
+		return static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * bytesPerPixel;
+	}
+
 #pragma endregion
 
 
@@ -0,0 +1,215 @@
+#include "LittleEngine/Graphics/render_target_pool.h"
+
+#include "LittleEngine/Utils/logger.h"
+
+
+namespace LittleEngine::Graphics
+{
+
+#pragma region Initialization / lifetime management.
+
+	void RenderTargetPool::Initialize(const RenderTargetPoolConfig& config)
+	{
+		if (m_initialized)
+		{
+			Utils::Logger::Warning("RenderTargetPool::Initialize : pool already initialized.");
+			return;
+		}
+
+		m_config = config;
+		m_frame = 0;
+		m_allocationCount = 0;
+		m_initialized = true;
+	}
+
+	void RenderTargetPool::Shutdown()
+	{
+		if (!m_initialized)
+			return;
+
+		for (auto& entry : m_entries)
+			entry.target->Cleanup();
+		m_entries.clear();
+
+		m_initialized = false;
+	}
+
+#pragma endregion
+
+
+	RenderTarget* RenderTargetPool::Acquire(const glm::ivec2& size, GLenum internalFormat)
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("RenderTargetPool::Acquire : pool not initialized.");
+			return nullptr;
+		}
+
+		// reuse the most recently used free target with the same description.
+		Entry* best = nullptr;
+		for (auto& entry : m_entries)
+		{
+			if (entry.inUse || entry.size != size || entry.format != internalFormat)
+				continue;
+			if (!best || entry.lastUsedFrame > best->lastUsedFrame)
+				best = &entry;
+		}
+
+		if (!best)
+		{
+			EnforceBudget(RenderTarget::GetMemoryUsage(size, internalFormat));
+
+			Entry entry;
+			entry.target = std::make_unique<RenderTarget>();
+			if (!entry.target->Create(size.x, size.y, internalFormat))
+			{
+				Utils::Logger::Error("RenderTargetPool::Acquire : failed to create a (" + std::to_string(size.x) + ", " + std::to_string(size.y) + ") target.");
+				entry.target->Cleanup();
+				return nullptr;
+			}
+			entry.size = size;
+			entry.format = internalFormat;
+			m_entries.push_back(std::move(entry));
+			m_allocationCount++;
+			best = &m_entries.back();
+		}
+
+		best->inUse = true;
+		best->temporary = false;
+		best->lastUsedFrame = m_frame;
+		return best->target.get();
+	}
+
+	RenderTarget* RenderTargetPool::AcquireTemporary(const glm::ivec2& size, GLenum internalFormat)
+	{
+		RenderTarget* target = Acquire(size, internalFormat);
+		if (!target)
+			return nullptr;
+
+		for (auto& entry : m_entries)
+		{
+			if (entry.target.get() == target)
+			{
+				entry.temporary = true;
+				break;
+			}
+		}
+		return target;
+	}
+
+	void RenderTargetPool::Release(RenderTarget* target)
+	{
+		if (!m_initialized || !target)
+			return;
+
+		for (auto& entry : m_entries)
+		{
+			if (entry.target.get() != target)
+				continue;
+
+			if (!entry.inUse)
+				Utils::Logger::Warning("RenderTargetPool::Release : target released twice.");
+			entry.inUse = false;
+			entry.temporary = false;
+			entry.lastUsedFrame = m_frame;
+			return;
+		}
+
+		Utils::Logger::Warning("RenderTargetPool::Release : target does not belong to the pool.");
+	}
+
+	void RenderTargetPool::EndFrame()
+	{
+		if (!m_initialized)
+			return;
+
+		for (auto& entry : m_entries)
+		{
+			if (entry.inUse && entry.temporary)
+			{
+				entry.inUse = false;
+				entry.temporary = false;
+				entry.lastUsedFrame = m_frame;
+			}
+		}
+
+		m_frame++;
+
+		// destroy the free targets which were not reused recently.
+		for (size_t i = m_entries.size(); i-- > 0;)
+		{
+			const Entry& entry = m_entries[i];
+			if (!entry.inUse && m_frame - entry.lastUsedFrame > static_cast<unsigned long long>(m_config.maxUnusedFrames))
+				Destroy(i);
+		}
+
+		EnforceBudget(0);
+	}
+
+	void RenderTargetPool::Clear()
+	{
+		for (size_t i = m_entries.size(); i-- > 0;)
+		{
+			if (!m_entries[i].inUse)
+				Destroy(i);
+		}
+	}
+
+	void RenderTargetPool::Destroy(size_t index)
+	{
+		m_entries[index].target->Cleanup();
+		if (index != m_entries.size() - 1)
+			m_entries[index] = std::move(m_entries.back());
+		m_entries.pop_back();
+	}
+
+	void RenderTargetPool::EnforceBudget(size_t reserve)
+	{
+		size_t freeMemory = reserve;
+		for (const auto& entry : m_entries)
+		{
+			if (!entry.inUse)
+				freeMemory += entry.target->GetMemoryUsage();
+		}
+
+		while (freeMemory > m_config.memoryBudget)
+		{
+			// find the least recently used free target.
+			size_t oldest = m_entries.size();
+			for (size_t i = 0; i < m_entries.size(); i++)
+			{
+				if (!m_entries[i].inUse && (oldest == m_entries.size() || m_entries[i].lastUsedFrame < m_entries[oldest].lastUsedFrame))
+					oldest = i;
+			}
+			if (oldest == m_entries.size())
+				break;	// only targets in use remain
+
+			freeMemory -= m_entries[oldest].target->GetMemoryUsage();
+			Destroy(oldest);
+		}
+	}
+
+#pragma region Statistics
+
+	size_t RenderTargetPool::GetMemoryUsage() const
+	{
+		size_t memory = 0;
+		for (const auto& entry : m_entries)
+			memory += entry.target->GetMemoryUsage();
+		return memory;
+	}
+
+	size_t RenderTargetPool::GetUsedTargetCount() const
+	{
+		size_t count = 0;
+		for (const auto& entry : m_entries)
+		{
+			if (entry.inUse)
+				count++;
+		}
+		return count;
+	}
+
+#pragma endregion
+
+}
@@ -1,5 +1,4 @@
 #include "LittleEngine/Graphics/renderer.h"
-#include "LittleEngine/Graphics/bitmap_helper.h"
 
 #include "LittleEngine/Utils/logger.h"
 #include "LittleEngine/internal.h"
@@ -8,11 +7,11 @@
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <stb_image/stb_image_write.h>
-
 
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <limits>
 
 
 namespace LittleEngine::Graphics
@@ -46,6 +45,36 @@ namespace LittleEngine::Graphics
 		}
     )";
 
+	const std::string sharpenFragmentShader = R"(
+		#version 330 core
+
+		out vec4 FragColor;
+		in vec2 TexCoords;
+
+		uniform sampler2D uTexture;
+		uniform float uSharpness;
+
+		void main()
+		{
+			vec2 texel = 1.0 / vec2(textureSize(uTexture, 0));
+
+			vec4 center = texture(uTexture, TexCoords);
+			vec3 north = texture(uTexture, TexCoords + vec2(0.0, texel.y)).rgb;
+			vec3 south = texture(uTexture, TexCoords - vec2(0.0, texel.y)).rgb;
+			vec3 east = texture(uTexture, TexCoords + vec2(texel.x, 0.0)).rgb;
+			vec3 west = texture(uTexture, TexCoords - vec2(texel.x, 0.0)).rgb;
+
+			// unsharp mask, clamped to the neighbourhood to avoid halos.
+			vec3 blur = (north + south + east + west) * 0.25;
+			vec3 color = center.rgb + (center.rgb - blur) * uSharpness;
+
+			vec3 minColor = min(center.rgb, min(min(north, south), min(east, west)));
+			vec3 maxColor = max(center.rgb, max(max(north, south), max(east, west)));
+
+			FragColor = vec4(clamp(color, minColor, maxColor), center.a);
+		}
+    )";
+
 	const std::string mergeFragmentShader = R"(
 		#version 330 core
 		in vec2 TexCoords;
@@ -73,6 +102,9 @@ namespace LittleEngine::Graphics
 	Texture Renderer::s_defaultTexture = Texture();
 	Font Renderer::s_defaultFont = Font();
 
+	// first entry of the clip rect table, used by the quads drawn without clip rect.
+	static const glm::vec4 s_noClipRect = { -1e30f, -1e30f, 1e30f, 1e30f };
+
 #pragma region init / shut down
 
 	void Renderer::Initialize(const Camera& camera, glm::ivec2 size, unsigned int quadCount)
@@ -93,6 +125,7 @@ namespace LittleEngine::Graphics
 		m_vertices.reserve(quadCount * 4);
 		m_indices.reserve(quadCount * 6);
 		m_textures.reserve(quadCount);
+		m_clipRects.assign(1, s_noClipRect);
 
 		// initialize buffer objects
 		glGenVertexArrays(1, &m_VAO);
@@ -120,6 +153,12 @@ namespace LittleEngine::Graphics
 		// texture index attribute
 		glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureIndex));
 		glEnableVertexAttribArray(3);
+		// depth attribute
+		glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, depth));
+		glEnableVertexAttribArray(4);
+		// clip rect index attribute
+		glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, clipIndex));
+		glEnableVertexAttribArray(5);
 
 		glBindVertexArray(0);
 
@@ -139,11 +178,22 @@ namespace LittleEngine::Graphics
 
 		UpdateWindowSize(size);
 
+		// check if the default framebuffer has a depth buffer (for the opaque pass on the screen).
+		GLint depthBits = 0;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+		m_screenHasDepth = glGetError() == GL_NO_ERROR && depthBits > 0;
+		m_screenDepthBits = m_screenHasDepth ? static_cast<int>(depthBits) : 0;
+
 
 		m_blitShader.Create(fullQuadVertexShader, blitImageFragmentShader, false);
 		m_blitShader.Use();
 		m_blitShader.SetInt("uTexture", 0); // set texture sampler to 0
 
+		m_sharpenShader.Create(fullQuadVertexShader, sharpenFragmentShader, false);
+		m_sharpenShader.Use();
+		m_sharpenShader.SetInt("uTexture", 0);
+
 		m_mergeLightSceneShader.Create(fullQuadVertexShader, mergeFragmentShader, false);
 		m_mergeLightSceneShader.Use();
 		m_mergeLightSceneShader.SetInt("sceneTexture", 0); // set scene texture sampler to 0
@@ -154,6 +204,9 @@ namespace LittleEngine::Graphics
 
 		SetBlendMode(BlendMode::Alpha);
 
+		m_targetPool.Initialize();
+		m_frameCapture.Initialize();
+
 	}
 
 	void Renderer::Shutdown()
@@ -170,6 +223,10 @@ namespace LittleEngine::Graphics
 		m_VBO = 0;
 		m_EBO = 0;
 
+		SetDirtyRectMode(false);	// releases the back buffer
+		m_targetPool.Shutdown();
+		m_frameCapture.Shutdown();	// writes the pending captures
+
 		m_vertices.clear();
 		m_indices.clear();
 		m_textures.clear();
@@ -220,13 +277,23 @@ namespace LittleEngine::Graphics
 		// MAYBE 
 
 
+		// skip the rects entirely outside of the clip rect (scrolled out items).
+		if (!m_clipStack.empty())
+		{
+			const glm::vec4& clipRect = m_clipStack.back();
+			if (glm::min(p0.x, p2.x) >= clipRect.z || glm::max(p0.x, p2.x) <= clipRect.x
+				|| glm::min(p0.y, p2.y) >= clipRect.w || glm::max(p0.y, p2.y) <= clipRect.y)
+				return;
+		}
+
+		float clip = GetClipIndex();
 		int index = m_vertices.size();
 
 
-		m_vertices.emplace_back(p0, uv0, color, texture.id);
-		m_vertices.emplace_back(p1, uv1, color, texture.id);
-		m_vertices.emplace_back(p2, uv2, color, texture.id);
-		m_vertices.emplace_back(p3, uv3, color, texture.id);
+		m_vertices.emplace_back(p0, uv0, color, texture.id, m_layer, clip);
+		m_vertices.emplace_back(p1, uv1, color, texture.id, m_layer, clip);
+		m_vertices.emplace_back(p2, uv2, color, texture.id, m_layer, clip);
+		m_vertices.emplace_back(p3, uv3, color, texture.id, m_layer, clip);
 
 		m_indices.push_back(index + 0);
 		m_indices.push_back(index + 1);
@@ -236,6 +303,36 @@ namespace LittleEngine::Graphics
 		m_indices.push_back(index + 3);
 
 		m_textures.push_back(texture);
+		m_quadOpaque.push_back(m_opaque);
+
+		m_quadCount++;
+	}
+
+	void Renderer::DrawQuad(const std::array<Vertex, 4>& vertices, Texture texture)
+	{
+		if (texture.id == 0)
+		{
+			Utils::Logger::Warning("RENDERER::DrawQuad : texture not loaded.");
+			texture = s_defaultTexture;	// use default texture
+		}
+
+		float clip = GetClipIndex();
+		int index = m_vertices.size();
+
+		for (const Vertex& vertex : vertices)
+		{
+			m_vertices.emplace_back(vertex.pos, vertex.uv, vertex.color, texture.id, m_layer, clip);
+		}
+
+		m_indices.push_back(index + 0);
+		m_indices.push_back(index + 1);
+		m_indices.push_back(index + 2);
+		m_indices.push_back(index + 0);
+		m_indices.push_back(index + 2);
+		m_indices.push_back(index + 3);
+
+		m_textures.push_back(texture);
+		m_quadOpaque.push_back(m_opaque);
 
 		m_quadCount++;
 	}
@@ -261,12 +358,13 @@ namespace LittleEngine::Graphics
 
 
 
+		float clip = GetClipIndex();
 		int index = m_vertices.size();
 
-		m_vertices.emplace_back(p0, uv0, color, s_defaultTexture.id);
-		m_vertices.emplace_back(p1, uv1, color, s_defaultTexture.id);
-		m_vertices.emplace_back(p2, uv2, color, s_defaultTexture.id);
-		m_vertices.emplace_back(p3, uv3, color, s_defaultTexture.id);
+		m_vertices.emplace_back(p0, uv0, color, s_defaultTexture.id, m_layer, clip);
+		m_vertices.emplace_back(p1, uv1, color, s_defaultTexture.id, m_layer, clip);
+		m_vertices.emplace_back(p2, uv2, color, s_defaultTexture.id, m_layer, clip);
+		m_vertices.emplace_back(p3, uv3, color, s_defaultTexture.id, m_layer, clip);
 
 		m_indices.push_back(index + 0);
 		m_indices.push_back(index + 1);
@@ -276,6 +374,7 @@ namespace LittleEngine::Graphics
 		m_indices.push_back(index + 3);
 
 		m_textures.push_back(s_defaultTexture);
+		m_quadOpaque.push_back(m_opaque);
 
 		m_quadCount++;
 
@@ -305,15 +404,17 @@ namespace LittleEngine::Graphics
 			triangleCount++;
 		}
 
+		float clip = GetClipIndex();
+
 		// all quads are (0123, 0345, 0567, ...)
 		for (size_t i = 0; i < triangleCount / 2; i++)
 		{
 			int index = m_vertices.size();
 
-			m_vertices.emplace_back(poly.vertices[0], glm::vec2{ 0, 0 }, color, s_defaultTexture.id); // first vertex for the quad
-			m_vertices.emplace_back(poly.vertices[2 * i + 1], glm::vec2{ 0, 0 }, color, s_defaultTexture.id); // current vertex for the quad
-			m_vertices.emplace_back(poly.vertices[2 * i + 2], glm::vec2{ 0, 0 }, color, s_defaultTexture.id); // next vertex for the quad
-			m_vertices.emplace_back(poly.vertices[2 * i + 3], glm::vec2{ 0, 0 }, color, s_defaultTexture.id); // first vertex again for the quad
+			m_vertices.emplace_back(poly.vertices[0], glm::vec2{ 0, 0 }, color, s_defaultTexture.id, m_layer, clip); // first vertex for the quad
+			m_vertices.emplace_back(poly.vertices[2 * i + 1], glm::vec2{ 0, 0 }, color, s_defaultTexture.id, m_layer, clip); // current vertex for the quad
+			m_vertices.emplace_back(poly.vertices[2 * i + 2], glm::vec2{ 0, 0 }, color, s_defaultTexture.id, m_layer, clip); // next vertex for the quad
+			m_vertices.emplace_back(poly.vertices[2 * i + 3], glm::vec2{ 0, 0 }, color, s_defaultTexture.id, m_layer, clip); // first vertex again for the quad
 
 			m_indices.push_back(index + 0);
 			m_indices.push_back(index + 1);
@@ -323,6 +424,7 @@ namespace LittleEngine::Graphics
 			m_indices.push_back(index + 3);
 
 			m_textures.push_back(s_defaultTexture);
+			m_quadOpaque.push_back(m_opaque);
 
 			m_quadCount++;
 		}
@@ -399,8 +501,24 @@ namespace LittleEngine::Graphics
 			return;
 		}
 
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordClear(color);
+
+		if (m_dirtyRectMode && m_renderTarget == nullptr)
+		{
+			// the screen is overwritten by the back buffer at EndFrame, the clear happens there.
+			if (color != m_dirtyClearColor)
+			{
+				m_dirtyClearColor = color;
+				m_fullRedraw = true;
+			}
+			return;
+		}
+
 		glClearColor(color.r, color.g, color.b, color.a);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (!m_scissor)
+			ResetDepthBase(m_renderTarget);
 		
 	}
 
@@ -418,6 +536,9 @@ namespace LittleEngine::Graphics
 		if (m_renderTarget == target)	// already binded.
 			return;
 
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordSetRenderTarget(target);
+
 		m_renderTarget = target;
 		int width, height;
 		if (target)
@@ -437,6 +558,11 @@ namespace LittleEngine::Graphics
 
 	void Renderer::BeginFrame()
 	{
+		if (!m_tracePath.empty() && !m_traceRecorder.IsRecording())
+			m_traceRecorder.Begin({ m_width, m_height }, m_renderTarget, (int)m_blendMode);
+
+		m_depthBases.clear();	// the depth of every target is cleared again before its first depth pass
+
 		Clear(); // clear the current render target
 		
 		
@@ -447,6 +573,26 @@ namespace LittleEngine::Graphics
 	void Renderer::EndFrame()
 	{
 		Flush(); // render everything queued
+
+		if (m_traceRecorder.IsRecording())	// the presentation is replayed by the renderer itself
+		{
+			m_traceRecorder.End(m_tracePath);
+			m_tracePath.clear();
+		}
+
+		if (m_dirtyRectMode)
+			PresentDirtyRegions();
+
+		if (m_frameCapture.IsRecording())
+		{
+			RenderTarget* old = GetRenderTarget();
+			SetRenderTarget();
+			m_frameCapture.CaptureFrame({ m_width, m_height }, true);
+			SetRenderTarget(old);
+		}
+		m_frameCapture.Update();	// hands the finished readbacks to the writer thread
+
+		m_targetPool.EndFrame();	// releases the temporary targets of the frame
 	}
 
 	void Renderer::SetWireframe(bool b)
@@ -461,49 +607,114 @@ namespace LittleEngine::Graphics
 		}
 	}
 
-	void Renderer::SaveScreenshot(RenderTarget* target, const std::string& name)
+	void Renderer::SetScissorRect(const glm::ivec4& rect)
 	{
-		RenderTarget* old = GetRenderTarget();
+		if (!m_indices.empty())
+		{
+			Flush();	// the queued quads keep the previous scissor.
+		}
 
-		int width, height;
-		int imageTarget;
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordSetScissor(rect);
 
-		if (target == nullptr)	// window
+		m_scissor = true;
+		m_scissorRect = rect;
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(rect.x, rect.y, rect.z, rect.w);
+	}
+
+	void Renderer::DisableScissor()
+	{
+		if (!m_indices.empty())
 		{
-			width = m_width;
-			height = m_height;
-			SetRenderTarget();
-			glReadBuffer(GL_BACK);
+			Flush();	// the queued quads keep the previous scissor.
 		}
-		else 
+
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordDisableScissor();
+
+		m_scissor = false;
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	void Renderer::PushClipRect(const Rect& rect)
+	{
+		glm::vec4 bounds = { rect.x, rect.y, rect.x + rect.z, rect.y + rect.w };
+		if (!m_clipStack.empty())
 		{
-			width = target->GetSize().x;
-			height = target->GetSize().y;
-			SetRenderTarget(target);
-			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			const glm::vec4& parent = m_clipStack.back();
+			bounds = { glm::max(bounds.x, parent.x), glm::max(bounds.y, parent.y), glm::min(bounds.z, parent.z), glm::min(bounds.w, parent.w) };
 		}
 
-		std::vector<unsigned char> pixels(width * height * 4);
+		m_clipStack.push_back(bounds);
+		m_clipIndex = -1;	// added to the table by the next draw
+	}
 
-		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	void Renderer::PopClipRect()
+	{
+		if (m_clipStack.empty())
+		{
+			Utils::Logger::Warning("Renderer::PopClipRect : no clip rect to pop.");
+			return;
+		}
 
+		m_clipStack.pop_back();
+		m_clipIndex = m_clipStack.empty() ? 0 : -1;
+	}
 
-		// swap pixels because opengl has bottom left as origin, instead of top left.
-		FlipBitmapVertically(pixels.data(), width, height, 4);
+	float Renderer::GetClipIndex()
+	{
+		if (m_clipIndex >= 0)
+			return static_cast<float>(m_clipIndex);
 
-		Utils::FileSystem::CreateDirectories("screenshots");
+		const glm::vec4& rect = m_clipStack.back();
+
+		// rects are often pushed again (parent after a child, same panel every item), reuse their entry.
+		for (size_t i = 1; i < m_clipRects.size(); i++)
+		{
+			if (m_clipRects[i] == rect)
+			{
+				m_clipIndex = static_cast<int>(i);
+				return static_cast<float>(m_clipIndex);
+			}
+		}
 
-		std::string path = Utils::FileSystem::GetNextFreeFilepath("screenshots", name, ".png");
+		if (m_clipRects.size() >= defaults::MAX_CLIP_RECTS)
+		{
+			Flush();	// the table of the queued quads is full, it starts over with the next flush
 
+			if (m_clipRects.size() >= defaults::MAX_CLIP_RECTS)
+			{
+				Utils::Logger::Warning("Renderer::GetClipIndex : clip rect table full, drawing unclipped.");
+				return 0.f;
+			}
+		}
 
-		stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4);
+		m_clipRects.push_back(rect);
+		m_clipIndex = static_cast<int>(m_clipRects.size() - 1);
+		return static_cast<float>(m_clipIndex);
+	}
+
+	void Renderer::SaveScreenshot(RenderTarget* target, const std::string& name)
+	{
+		RenderTarget* old = GetRenderTarget();
+
+		SetRenderTarget(target);
+
+		if (target == nullptr)	// window
+			m_frameCapture.CaptureScreenshot({ m_width, m_height }, true, name);
+		else
+			m_frameCapture.CaptureScreenshot(target->GetSize(), false, name);
 
 		SetRenderTarget(old);
-		
 	}
 	
 	void Renderer::SetBlendMode(BlendMode mode)
 	{
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordSetBlendMode((int)mode);
+
+		m_blendMode = mode;
 		switch (mode)
 		{
 			case BlendMode::None:
@@ -574,12 +785,142 @@ namespace LittleEngine::Graphics
 		}
 
 
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordFlush(*m_camera, m_vertices.data(), m_textures.data(), m_quadOpaque.data(), m_clipRects.data(), m_textures.size());
+
+		if (m_dirtyRectMode && m_renderTarget == nullptr)
+		{
+			DeferDirtyFlush();	// drawn at EndFrame, once the damaged region is known.
+			return;
+		}
+
+		RenderDrawQueue(m_camera->GetViewMatrix(), m_camera->GetProjectionMatrix());
+
+		ClearDrawQueue();	// clear draw queue after flushing
+
+	}
+
+	void Renderer::FlushViews(const std::vector<RenderView>& views)
+	{
+		if (m_vertices.empty() || m_textures.empty() || !m_VAO)
+			return;
+
+		if (m_width <= 0 || m_height <= 0)
+		{
+			ClearDrawQueue();
+			return;
+		}
+
+		if (views.empty() || views[0].camera == nullptr)
+		{
+			Utils::Logger::Warning("Renderer::FlushViews : no view, flushing with the current camera.");
+			Flush();
+			return;
+		}
+
+		if (m_dirtyRectMode && m_renderTarget == nullptr)
+		{
+			// the dirty regions are tracked for a single camera.
+			Utils::Logger::Warning("Renderer::FlushViews : views are not supported on the screen in dirty rect mode, only the first view is drawn.");
+			const Camera* old = m_camera;
+			m_camera = views[0].camera;
+			Flush();
+			m_camera = old;
+			return;
+		}
+
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordFlushViews(views, m_vertices.data(), m_textures.data(), m_quadOpaque.data(), m_clipRects.data(), m_textures.size());
+
+		bool depthPass = PrepareDrawQueue();
+
+		glm::ivec2 targetSize = m_renderTarget ? m_renderTarget->GetSize() : glm::ivec2(m_width, m_height);
+		for (const RenderView& view : views)
+		{
+			if (view.camera == nullptr)
+				continue;
+
+			glm::ivec4 viewport = view.viewport;
+			if (viewport.z <= 0 || viewport.w <= 0)
+				viewport = { 0, 0, targetSize.x, targetSize.y };
+			glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+
+			glm::vec4 bounds = view.camera->GetVisibleBounds();
+			DrawPreparedQueue(view.camera->GetViewMatrix(), view.camera->GetProjectionMatrix(), depthPass, view.cull ? &bounds : nullptr);
+		}
+		glViewport(0, 0, targetSize.x, targetSize.y);
+
+		ClearBatch();
+		ClearDrawQueue();
+	}
+
+	void Renderer::RenderDrawQueue(const glm::mat4& view, const glm::mat4& projection)
+	{
+		bool depthPass = PrepareDrawQueue();
+		DrawPreparedQueue(view, projection, depthPass, nullptr);
+		ClearBatch();
+	}
+
+	bool Renderer::PrepareDrawQueue()
+	{
+		size_t quadCount = m_textures.size();
+
+		// sort the quads back-to-front: by layer, then in submission order.
+		m_drawOrder.resize(quadCount);
+		bool layered = false;
+		for (size_t i = 0; i < quadCount; i++)
+		{
+			m_drawOrder[i] = static_cast<unsigned int>(i);
+			layered |= m_vertices[i * 4].depth != m_vertices[0].depth;
+		}
+		if (layered)
+		{
+			std::stable_sort(m_drawOrder.begin(), m_drawOrder.end(), [this](unsigned int a, unsigned int b) {
+				return m_vertices[a * 4].depth < m_vertices[b * 4].depth;
+			});
+		}
+
+		bool hasOpaque = std::find(m_quadOpaque.begin(), m_quadOpaque.end(), 1) != m_quadOpaque.end();
+		if (!hasOpaque || !CanUseDepthPass())
+		{
+			BatchQuads(m_drawOrder, nullptr);
+			m_opaqueBatchCount = 0;
+			UploadBatches();
+			return false;
+		}
+
+		// every quad gets its own depth from its back-to-front rank, front quads are closer to the camera.
+		// (ortho projection with near = -1, far = 1: eye z is the opposite of the NDC depth.)
+		m_quadDepths.resize(quadCount);
+		m_opaqueOrder.clear();
+		m_translucentOrder.clear();
+		for (size_t rank = 0; rank < quadCount; rank++)
+		{
+			unsigned int quad = m_drawOrder[rank];
+			m_quadDepths[quad] = -1.f + 2.f * static_cast<float>(rank + 1) / static_cast<float>(quadCount + 1);
+			if (m_quadOpaque[quad])
+				m_opaqueOrder.push_back(quad);
+			else
+				m_translucentOrder.push_back(quad);
+		}
+		std::reverse(m_opaqueOrder.begin(), m_opaqueOrder.end());
+
+		// both passes share one upload: the opaque batches come first.
+		BatchQuads(m_opaqueOrder, m_quadDepths.data());
+		m_opaqueBatchCount = m_batchRanges.size();
+		BatchQuads(m_translucentOrder, m_quadDepths.data());
+		UploadBatches();
+		return true;
+	}
+
+	void Renderer::DrawPreparedQueue(const glm::mat4& view, const glm::mat4& projection, bool depthPass, const glm::vec4* cullBounds)
+	{
 		// Bind shader
 		shader.Use();
 
 		// initializes uniform variables
-		shader.SetMat4("view", m_camera->GetViewMatrix());
-		shader.SetMat4("projection", m_camera->GetProjectionMatrix());
+		shader.SetMat4("view", view);
+		shader.SetMat4("projection", projection);
 		// set uniform texture sampler
 		// TODO: MAYBE MOVE SOMEWHERE ELSE IF NOT NEEDED EACH FRAME
 		for (int i = 0; i < defaults::MAX_TEXTURE_SLOTS; ++i)
@@ -590,9 +931,68 @@ namespace LittleEngine::Graphics
 
 		//shader.SetIntArray("uTextures", defaults::MAX_TEXTURE_SLOTS, m_samplers);
 
+		// clip rects of the queued quads (PushClipRect), the shader writes the distances to their sides.
+		// always uploaded: some drivers clip with the written distances even when GL_CLIP_DISTANCEi is disabled.
+		shader.SetVec4Array("uClipRects", static_cast<int>(m_clipRects.size()), m_clipRects.data());
+		bool clipped = m_clipRects.size() > 1 && CanUseClipDistances();
+		if (clipped)
+		{
+			for (int i = 0; i < 4; i++)
+				glEnable(GL_CLIP_DISTANCE0 + i);
+		}
+
+		// binding vertex array
+		glBindVertexArray(m_VAO);
+
+		if (!depthPass)
+		{
+			DrawBatches(0, m_batchRanges.size(), cullBounds);
+		}
+		else
+		{
+			// depths are only meaningful within a flush, quads of a later flush are drawn over the previous ones:
+			// every depth pass gets a slice of the depth range closer than the previous ones, the depth is only cleared when they run out.
+			glm::vec2 depthRange = ReserveDepthRange(m_textures.size());
+			glDepthRange(depthRange.x, depthRange.y);
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(GL_LESS);
+
+			// opaque pass: front-to-back, no blending, cut out pixels are discarded so they do not write depth.
+			glDisable(GL_BLEND);
+			shader.SetFloat("uAlphaCutoff", 0.5f);
+			DrawBatches(0, m_opaqueBatchCount, cullBounds);
+
+			// translucent pass: back-to-front, blended, tested against the opaque quads but not writing depth.
+			glDepthMask(GL_FALSE);
+			SetBlendMode(m_blendMode);
+			shader.SetFloat("uAlphaCutoff", 0.f);
+			DrawBatches(m_opaqueBatchCount, m_batchRanges.size(), cullBounds);
+
+			glDepthMask(GL_TRUE);
+			glDisable(GL_DEPTH_TEST);
+			glDepthRange(0.0, 1.0);
+		}
+
+		// Optionally unbind VAO (not strictly needed)
+		glBindVertexArray(0);
+
+		if (clipped)
+		{
+			for (int i = 0; i < 4; i++)
+				glDisable(GL_CLIP_DISTANCE0 + i);
+		}
+
+		GLenum err = glGetError();
+		if (err != GL_NO_ERROR) {
+			Utils::Logger::Error("OpenGL Error in Renderer::DrawPreparedQueue() - Code: " + std::to_string(err));
+		}
+	}
+
+	void Renderer::BatchQuads(const std::vector<unsigned int>& order, const float* depths)
+	{
 		size_t quadCountInBatch = 0;
 
-		for (size_t i = 0; i < m_textures.size(); ++i)
+		for (unsigned int i : order)
 		{
 			int slot = AddTextureToBatch(m_textures[i]);
 			if (slot == -1)
@@ -606,23 +1006,27 @@ namespace LittleEngine::Graphics
 				if (slot == -1)
 				{
 					Utils::Logger::Error("RENDERER::FLUSH : texture slot full even after flush.");
+					ClearBatch();
 					return;
 				}
 
 				quadCountInBatch = 0;
 			}
 
+			// indices are absolute: all the batches of the flush share one upload.
+			unsigned int batchVertexStart = static_cast<unsigned int>(m_verticesBatch.size());
+
 			// Add quad vertices with texture slot
 			for (int v = 0; v < 4; ++v)
 			{
 				Vertex vert = m_vertices[i * 4 + v];
 				vert.textureIndex = static_cast<float>(slot);
+				vert.depth = depths ? depths[i] : 0.f;
 				m_verticesBatch.push_back(vert);
 			}
 
 			// Add quad indices adjusted relative to current batch
 			unsigned int quadVertexStart = i * 4;
-			unsigned int batchVertexStart = quadCountInBatch * 4;
 
 			for (int idx = 0; idx < 6; ++idx)
 			{
@@ -631,6 +1035,21 @@ namespace LittleEngine::Graphics
 				m_indicesBatch.push_back(localIndex + batchVertexStart);
 			}
 
+			// bounds of the quads, per chunk, for the per-view culling.
+			if (m_cullChunks.empty() || m_chunkQuadCount == s_cullChunkQuads)
+			{
+				m_cullChunks.push_back({ m_indicesBatch.size() - 6, 0, glm::vec4(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()) });
+				m_chunkQuadCount = 0;
+			}
+			CullChunk& chunk = m_cullChunks.back();
+			for (int v = 0; v < 4; ++v)
+			{
+				const glm::vec2& pos = m_vertices[i * 4 + v].pos;
+				chunk.bounds = { glm::min(glm::vec2(chunk.bounds), pos), glm::max(glm::vec2(chunk.bounds.z, chunk.bounds.w), pos) };
+			}
+			chunk.indexCount += 6;
+			m_chunkQuadCount++;
+
 			++quadCountInBatch;
 		}
 
@@ -638,46 +1057,173 @@ namespace LittleEngine::Graphics
 		{
 			RenderBatch();
 		}
+	}
 
+	bool Renderer::CanUseDepthPass()
+	{
+		bool hasDepth = m_renderTarget ? m_renderTarget->HasDepthStencil() : m_screenHasDepth;
+		if (!hasDepth)
+			return false;
 
-		//if (m_renderTarget != nullptr)
-		//	m_renderTarget->Unbind();
+		// custom shaders which ignore the vertex depth would draw every quad at the same depth.
+		// the attribute is only queried when the shader changes, not at every flush.
+		if (shader.id != m_depthShader)
+		{
+			m_depthShader = shader.id;
+			m_depthShaderReadsDepth = glGetAttribLocation(shader.id, "aDepth") == 4;
+		}
+		return m_depthShaderReadsDepth;
+	}
 
+	glm::vec2 Renderer::ReserveDepthRange(size_t quadCount)
+	{
+		// window depths of the quads are (rank + 1) / (quadCount + 1) of the slice, a few steps of the depth buffer apart.
+		// (render targets are GL_DEPTH24_STENCIL8, float depths beyond 24 bits would not be more precise anyway.)
+		int depthBits = m_renderTarget ? 24 : glm::clamp(m_screenDepthBits, 8, 24);
+		float size = static_cast<float>(quadCount + 1) * 8.f / static_cast<float>(1 << depthBits);
+
+		auto it = std::find_if(m_depthBases.begin(), m_depthBases.end(), [this](const std::pair<RenderTarget*, float>& base) {
+			return base.first == m_renderTarget;
+		});
+		if (it == m_depthBases.end())
+		{
+			m_depthBases.push_back({ m_renderTarget, 0.f });
+			it = m_depthBases.end() - 1;
+		}
 
-		ClearDrawQueue();	// clear draw queue after flushing
+		if (it->second - size < 0.f)
+		{
+			// first depth pass on the target this frame, or the slices ran out: clear the whole depth buffer, ignoring the scissor.
+			GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+			glDisable(GL_SCISSOR_TEST);
+			glDepthMask(GL_TRUE);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			if (scissor)
+				glEnable(GL_SCISSOR_TEST);
+			it->second = 1.f;
+		}
 
+		glm::vec2 range = { glm::max(it->second - size, 0.f), it->second };
+		it->second = range.x;
+		return range;
 	}
 
+	void Renderer::ResetDepthBase(RenderTarget* target)
+	{
+		for (std::pair<RenderTarget*, float>& base : m_depthBases)
+		{
+			if (base.first == target)
+			{
+				base.second = 1.f;
+				return;
+			}
+		}
+		m_depthBases.push_back({ target, 1.f });
+	}
+
+	bool Renderer::CanUseClipDistances()
+	{
+		// custom shaders without the clip rects would leave gl_ClipDistance undefined: the quads could be clipped at random.
+		// the uniform is only queried when the shader changes, not at every flush.
+		if (shader.id != m_clipShader)
+		{
+			m_clipShader = shader.id;
+			m_clipShaderWritesDistances = glGetUniformLocation(shader.id, "uClipRects") != -1;
+			if (!m_clipShaderWritesDistances && !m_clipWarned)
+			{
+				m_clipWarned = true;
+				Utils::Logger::Warning("Renderer::CanUseClipDistances : the shader does not use uClipRects, PushClipRect is ignored.");
+			}
+		}
+		return m_clipShaderWritesDistances;
+	}
+
+
 	void Renderer::RenderBatch()
 	{
+		size_t indexCount = m_indicesBatch.size() - m_batchIndexStart;
+		if (indexCount > 0)
+			m_batchRanges.push_back({ m_batchIndexStart, indexCount, m_texturesBatch, m_bindedTextureCount, m_batchChunkStart, m_cullChunks.size() - m_batchChunkStart });
+		m_batchIndexStart = m_indicesBatch.size();
+		m_batchChunkStart = m_cullChunks.size();
+		m_chunkQuadCount = s_cullChunkQuads;	// the next quad starts a new chunk
+
+		// start a new texture slot set.
+		m_texturesBatch.fill(Texture{});
+		m_bindedTextureCount = 0;
+	}
 
+	void Renderer::UploadBatches()
+	{
+		if (m_batchRanges.empty())
+			return;
 
-		// binding vertex array
 		glBindVertexArray(m_VAO);
 
-		// upload vertex data
+		// upload vertex data of every batch
 		glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
 		glBufferData(GL_ARRAY_BUFFER, m_verticesBatch.size() * sizeof(Vertex), m_verticesBatch.data(), GL_STREAM_DRAW);
 
-		// Upload index data
+		// Upload index data of every batch
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indicesBatch.size() * sizeof(unsigned int), m_indicesBatch.data(), GL_STREAM_DRAW);
 
+		glBindVertexArray(0);
+	}
 
-		// draw data
-		glDrawElements(GL_TRIANGLES, m_indicesBatch.size(), GL_UNSIGNED_INT, nullptr);
+	void Renderer::DrawBatches(size_t first, size_t last, const glm::vec4* cullBounds)
+	{
+		// draw each batch with its textures.
+		// (without texture arrays, the slots have to be rebound between batches, so they cannot be merged into a multi-draw.)
+		for (size_t b = first; b < last; b++)
+		{
+			const BatchRange& batch = m_batchRanges[b];
 
+			if (!cullBounds)
+			{
+				for (int slot = 0; slot < batch.textureCount; slot++)
+					batch.textures[slot].Bind(slot);
 
-		// Optionally unbind VAO (not strictly needed)
-		glBindVertexArray(0);
+				glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(batch.indexCount), GL_UNSIGNED_INT, (void*)(batch.indexStart * sizeof(unsigned int)));
+				continue;
+			}
 
-		ClearBatch();
+			// draws the runs of consecutive visible chunks, the submission order is kept.
+			bool bound = false;
+			size_t runStart = 0;
+			size_t runCount = 0;
+			for (size_t c = batch.firstChunk; c <= batch.firstChunk + batch.chunkCount; c++)
+			{
+				bool visible = false;
+				if (c < batch.firstChunk + batch.chunkCount)
+				{
+					const CullChunk& chunk = m_cullChunks[c];
+					visible = chunk.bounds.x <= cullBounds->z && chunk.bounds.z >= cullBounds->x
+						&& chunk.bounds.y <= cullBounds->w && chunk.bounds.w >= cullBounds->y;
+
+					if (visible)
+					{
+						if (runCount == 0)
+							runStart = chunk.indexStart;
+						runCount += chunk.indexCount;
+						continue;
+					}
+				}
 
-		GLenum err = glGetError();
-		if (err != GL_NO_ERROR) {
-			Utils::Logger::Error("OpenGL Error in Renderer::RenderBatch() - Code: " + std::to_string(err));
-		}
+				if (runCount == 0)
+					continue;
+
+				if (!bound)
+				{
+					for (int slot = 0; slot < batch.textureCount; slot++)
+						batch.textures[slot].Bind(slot);
+					bound = true;
+				}
 
+				glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(runCount), GL_UNSIGNED_INT, (void*)(runStart * sizeof(unsigned int)));
+				runCount = 0;
+			}
+		}
 	}
 
 	int Renderer::AddTextureToBatch(Texture texture)
@@ -694,9 +1240,8 @@ namespace LittleEngine::Graphics
 		if (m_bindedTextureCount == defaults::MAX_TEXTURE_SLOTS)
 			return -1;
 
-		// bind the texture.
+		// the texture is bound when the batch is submitted.
 		m_texturesBatch[m_bindedTextureCount] = texture;
-		texture.Bind(m_bindedTextureCount);
 
 		return m_bindedTextureCount++;
 
@@ -742,13 +1287,29 @@ namespace LittleEngine::Graphics
 		glBindVertexArray(0);
 	}
 
-	void Renderer::BlitImage(const Texture& texture)
+	const std::string& Renderer::GetFullscreenVertexShader()
+	{
+		return fullQuadVertexShader;
+	}
+
+	void Renderer::BlitImage(const Texture& texture, float sharpness)
 	{
 		if (texture.id == 0)
 			return;
+
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordBlit(texture, sharpness);
 		
-		m_blitShader.Use(); // Use the blit shader
-		//m_blitShader.SetInt("uTexture", 0); // Set the texture sampler to 0 NO need to set it again, already set in Initialize
+		if (sharpness > 0.f)
+		{
+			m_sharpenShader.Use();
+			m_sharpenShader.SetFloat("uSharpness", sharpness);
+		}
+		else
+		{
+			m_blitShader.Use(); // Use the blit shader
+			//m_blitShader.SetInt("uTexture", 0); // Set the texture sampler to 0 NO need to set it again, already set in Initialize
+		}
 		texture.Bind(0); // Bind texture to slot 0
 		
 		FlushFullscreenQuad(); // Render the fullscreen quad with the bound texture
@@ -763,6 +1324,9 @@ namespace LittleEngine::Graphics
 		if (scene.id == 0 || light.id == 0)
 			return;
 
+		if (m_traceRecorder.IsRecording())
+			m_traceRecorder.RecordMergeLightScene(scene, light);
+
 		m_mergeLightSceneShader.Use(); // Use the merge shader
 		scene.Bind(0); // Bind scene texture to slot 0
 		light.Bind(1); // Bind light texture to slot 1
@@ -773,6 +1337,251 @@ namespace LittleEngine::Graphics
 
 #pragma endregion
 
+#pragma region Dirty rect
+
+	// FNV-1a hash of the bytes, continued from hash.
+	static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// hash of a quad (4 vertices), its texture, its clip rect, its opaque flag and the state of its flush (stateHash).
+	static size_t HashQuad(const Vertex* vertices, GLuint textureId, const glm::vec4& clipRect, unsigned char opaque, uint64_t stateHash)
+	{
+		// the clip rect is hashed by value, its index in the table can change between frames.
+		Vertex quad[4] = { vertices[0], vertices[1], vertices[2], vertices[3] };
+		for (Vertex& vertex : quad)
+			vertex.clipIndex = 0.f;
+
+		uint64_t hash = HashBytes(stateHash, quad, sizeof(quad));
+		hash = HashBytes(hash, &clipRect, sizeof(glm::vec4));
+		hash = HashBytes(hash, &textureId, sizeof(GLuint));
+		hash = HashBytes(hash, &opaque, sizeof(unsigned char));
+		return static_cast<size_t>(hash);
+	}
+
+	void Renderer::SetDirtyRectMode(bool enabled)
+	{
+		if (m_dirtyRectMode == enabled)
+			return;
+
+		if (!m_indices.empty())
+			Flush();	// flush with the previous mode.
+
+		// the draws deferred so far this frame would be lost, they are presented now.
+		if (m_dirtyRectMode && m_deferredFlushCount > 0)
+			PresentDirtyRegions();
+
+		m_dirtyRectMode = enabled;
+		m_fullRedraw = true;
+		m_quadRecords.clear();
+		m_previousQuadRecords.clear();
+		m_deferredFlushes.clear();
+		m_deferredFlushCount = 0;
+
+		if (!enabled && m_backBuffer.GetSize().x > 0)
+			m_backBuffer.Cleanup();
+	}
+
+	void Renderer::DeferDirtyFlush()
+	{
+		// record the screen-space bounds of every quad with the current camera.
+		glm::mat4 view = m_camera->GetViewMatrix();
+		glm::mat4 projection = m_camera->GetProjectionMatrix();
+		glm::mat4 viewProjection = projection * view;
+
+		// a change of the state the flush is replayed with (e.g. a hit flash swapping the shader) dirties its quads.
+		const int blendMode = static_cast<int>(m_blendMode);
+		const int scissor = m_scissor ? 1 : 0;
+		uint64_t stateHash = HashBytes(14695981039346656037ull, &blendMode, sizeof(int));
+		stateHash = HashBytes(stateHash, &shader.id, sizeof(GLuint));
+		stateHash = HashBytes(stateHash, &scissor, sizeof(int));
+		if (m_scissor)
+			stateHash = HashBytes(stateHash, &m_scissorRect, sizeof(glm::ivec4));
+
+		for (size_t i = 0; i < m_textures.size(); i++)
+		{
+			// world bounds of the quad, restricted to its clip rect.
+			glm::vec4 world{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+			for (int v = 0; v < 4; v++)
+			{
+				const glm::vec2& pos = m_vertices[i * 4 + v].pos;
+				world = { glm::min(world.x, pos.x), glm::min(world.y, pos.y), glm::max(world.z, pos.x), glm::max(world.w, pos.y) };
+			}
+			const glm::vec4& clipRect = m_clipRects[static_cast<size_t>(m_vertices[i * 4].clipIndex)];
+			world = { glm::max(world.x, clipRect.x), glm::max(world.y, clipRect.y), glm::min(world.z, clipRect.z), glm::min(world.w, clipRect.w) };
+			if (world.x > world.z || world.y > world.w)
+				world = { world.x, world.y, world.x, world.y };	// fully clipped
+
+			glm::vec2 min{ std::numeric_limits<float>::max() };
+			glm::vec2 max{ std::numeric_limits<float>::lowest() };
+			for (int v = 0; v < 4; v++)
+			{
+				glm::vec2 corner{ v == 1 || v == 2 ? world.z : world.x, v >= 2 ? world.w : world.y };
+				glm::vec4 clip = viewProjection * glm::vec4(corner, 0.f, 1.f);
+				glm::vec2 pixel = (glm::vec2(clip) / clip.w * 0.5f + 0.5f) * glm::vec2(m_width, m_height);
+				min = glm::min(min, pixel);
+				max = glm::max(max, pixel);
+			}
+
+			// 1 pixel margin for rasterization and filtering, clamped to the screen.
+			glm::ivec4 bounds{
+				glm::clamp(static_cast<int>(glm::floor(min.x)) - 1, 0, m_width),
+				glm::clamp(static_cast<int>(glm::floor(min.y)) - 1, 0, m_height),
+				glm::clamp(static_cast<int>(glm::ceil(max.x)) + 1, 0, m_width),
+				glm::clamp(static_cast<int>(glm::ceil(max.y)) + 1, 0, m_height)
+			};
+
+			m_quadRecords.push_back({ bounds, HashQuad(&m_vertices[i * 4], m_textures[i].id, clipRect, m_quadOpaque[i], stateHash) });
+		}
+
+		// keep the draw data until EndFrame, swapping vectors to reuse their storage.
+		if (m_deferredFlushCount == m_deferredFlushes.size())
+			m_deferredFlushes.emplace_back();
+
+		DeferredFlush& deferred = m_deferredFlushes[m_deferredFlushCount++];
+		deferred.vertices.swap(m_vertices);
+		deferred.indices.swap(m_indices);
+		deferred.textures.swap(m_textures);
+		deferred.opaque.swap(m_quadOpaque);
+		deferred.clipRects.swap(m_clipRects);
+		deferred.view = view;
+		deferred.projection = projection;
+		deferred.blendMode = m_blendMode;
+		deferred.shader = shader.id;
+		deferred.scissor = m_scissor;
+		deferred.scissorRect = m_scissorRect;
+
+		ClearDrawQueue();
+	}
+
+	void Renderer::PresentDirtyRegions()
+	{
+		if (m_width <= 0 || m_height <= 0)
+			return;
+
+		if (m_backBuffer.GetSize() != glm::ivec2(m_width, m_height))
+		{
+			if (m_backBuffer.GetSize().x > 0)
+				m_backBuffer.Cleanup();
+			m_backBuffer.Create(m_width, m_height, GL_RGB);
+			m_fullRedraw = true;
+		}
+
+		// union of the regions that changed since last frame {x0, y0, x1, y1}
+		glm::ivec4 dirty{ m_width, m_height, 0, 0 };
+		auto addRegion = [&dirty](const glm::ivec4& bounds)
+			{
+				if (bounds.x >= bounds.z || bounds.y >= bounds.w)
+					return;	// off screen
+				dirty = { glm::min(dirty.x, bounds.x), glm::min(dirty.y, bounds.y),
+						  glm::max(dirty.z, bounds.z), glm::max(dirty.w, bounds.w) };
+			};
+
+		if (m_fullRedraw)
+		{
+			addRegion({ 0, 0, m_width, m_height });
+		}
+		else
+		{
+			// quads are compared in submission order, any difference dirties both versions.
+			size_t count = std::max(m_quadRecords.size(), m_previousQuadRecords.size());
+			for (size_t i = 0; i < count; i++)
+			{
+				const QuadRecord* current = i < m_quadRecords.size() ? &m_quadRecords[i] : nullptr;
+				const QuadRecord* previous = i < m_previousQuadRecords.size() ? &m_previousQuadRecords[i] : nullptr;
+
+				if (current && previous && current->hash == previous->hash && current->bounds == previous->bounds)
+					continue;
+
+				if (current) addRegion(current->bounds);
+				if (previous) addRegion(previous->bounds);
+			}
+		}
+
+		bool hasDirtyRegion = dirty.x < dirty.z && dirty.y < dirty.w;
+		m_lastDirtyRegion = hasDirtyRegion ? glm::ivec4(dirty.x, dirty.y, dirty.z - dirty.x, dirty.w - dirty.y) : glm::ivec4(0);
+
+		RenderTarget* old = GetRenderTarget();
+		BlendMode oldBlendMode = m_blendMode;
+		GLuint oldShader = shader.id;
+
+		if (hasDirtyRegion)
+		{
+			// redraw every quad of the frame, the scissor limits the work to the dirty region.
+			SetRenderTarget(&m_backBuffer);
+			glEnable(GL_SCISSOR_TEST);
+			glScissor(m_lastDirtyRegion.x, m_lastDirtyRegion.y, m_lastDirtyRegion.z, m_lastDirtyRegion.w);
+			glClearColor(m_dirtyClearColor.r, m_dirtyClearColor.g, m_dirtyClearColor.b, m_dirtyClearColor.a);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			ResetDepthBase(&m_backBuffer);	// the replayed quads stay within the cleared region
+
+			for (size_t i = 0; i < m_deferredFlushCount; i++)
+			{
+				DeferredFlush& deferred = m_deferredFlushes[i];
+				m_vertices.swap(deferred.vertices);
+				m_indices.swap(deferred.indices);
+				m_textures.swap(deferred.textures);
+				m_quadOpaque.swap(deferred.opaque);
+				m_clipRects.swap(deferred.clipRects);
+
+				// the flush is replayed with its blend mode, shader and scissor (within the dirty region).
+				SetBlendMode(deferred.blendMode);
+				shader.id = deferred.shader;
+				glm::ivec4 region = { m_lastDirtyRegion.x, m_lastDirtyRegion.y, m_lastDirtyRegion.x + m_lastDirtyRegion.z, m_lastDirtyRegion.y + m_lastDirtyRegion.w };
+				if (deferred.scissor)
+				{
+					region = { glm::max(region.x, deferred.scissorRect.x), glm::max(region.y, deferred.scissorRect.y),
+							   glm::min(region.z, deferred.scissorRect.x + deferred.scissorRect.z), glm::min(region.w, deferred.scissorRect.y + deferred.scissorRect.w) };
+				}
+				glScissor(region.x, region.y, glm::max(region.z - region.x, 0), glm::max(region.w - region.y, 0));
+
+				RenderDrawQueue(deferred.view, deferred.projection);
+
+				ClearDrawQueue();
+			}
+
+			shader.id = oldShader;
+		}
+
+		for (size_t i = 0; i < m_deferredFlushCount; i++)
+		{
+			m_deferredFlushes[i].vertices.clear();
+			m_deferredFlushes[i].indices.clear();
+			m_deferredFlushes[i].textures.clear();
+			m_deferredFlushes[i].opaque.clear();
+			m_deferredFlushes[i].clipRects.clear();
+		}
+		m_deferredFlushCount = 0;
+
+		// present the back buffer.
+		glDisable(GL_SCISSOR_TEST);
+		SetRenderTarget(nullptr);
+		SetBlendMode(BlendMode::None);
+		BlitImage(m_backBuffer.GetTexture());
+		SetBlendMode(oldBlendMode);
+		SetRenderTarget(old);
+
+		// the scissor of the user is restored.
+		if (m_scissor)
+		{
+			glEnable(GL_SCISSOR_TEST);
+			glScissor(m_scissorRect.x, m_scissorRect.y, m_scissorRect.z, m_scissorRect.w);
+		}
+
+		m_previousQuadRecords.swap(m_quadRecords);
+		m_quadRecords.clear();
+		m_fullRedraw = false;
+	}
+
+#pragma endregion
+
 #pragma region Clear frame / batch
 
 	void Renderer::ClearDrawQueue()
@@ -781,6 +1590,11 @@ namespace LittleEngine::Graphics
 		m_vertices.clear();
 		m_indices.clear();
 		m_textures.clear();
+		m_quadOpaque.clear();
+
+		// the clip rect table starts over, the current rect is added again by the next draw.
+		m_clipRects.assign(1, s_noClipRect);
+		m_clipIndex = m_clipStack.empty() ? 0 : -1;
 
 		m_quadCount = 0;
 	}
@@ -791,6 +1605,12 @@ namespace LittleEngine::Graphics
 		m_indicesBatch.clear();
 		m_texturesBatch.fill(Texture{});
 		m_bindedTextureCount = 0;
+		m_batchRanges.clear();
+		m_batchIndexStart = 0;
+		m_opaqueBatchCount = 0;
+		m_cullChunks.clear();
+		m_batchChunkStart = 0;
+		m_chunkQuadCount = 0;
 	}
 
 #pragma endregion
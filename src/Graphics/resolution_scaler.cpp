@@ -0,0 +1,85 @@
+#include "LittleEngine/Graphics/resolution_scaler.h"
+
+#include "LittleEngine/Utils/logger.h"
+
+
+namespace LittleEngine::Graphics
+{
+
+	void ResolutionScaler::Initialize(const ResolutionScalerConfig& config)
+	{
+		m_config = config;
+
+		if (m_config.minScale <= 0.f || m_config.minScale > m_config.maxScale)
+		{
+			Utils::Logger::Warning("ResolutionScaler::Initialize: invalid scale range [" + std::to_string(m_config.minScale) + ", " + std::to_string(m_config.maxScale) + "], using [0.5, 1].");
+			m_config.minScale = 0.5f;
+			m_config.maxScale = 1.f;
+		}
+
+		m_scale = m_config.maxScale;
+		m_averageFrameTime = m_config.targetFrameTime;
+		m_cooldown = m_config.cooldownFrames;
+	}
+
+	bool ResolutionScaler::Update(float frameTime)
+	{
+		if (m_fixedResolution.x > 0 && m_fixedResolution.y > 0)
+			return false;
+
+		// smooth the frame time so a single spike does not change the resolution.
+		m_averageFrameTime = glm::mix(m_averageFrameTime, frameTime, 0.1f);
+
+		if (m_cooldown > 0)
+		{
+			m_cooldown--;
+			return false;
+		}
+
+		float scale = m_scale;
+		if (m_averageFrameTime > m_config.targetFrameTime * m_config.downscaleThreshold)
+			scale -= m_config.step;
+		else if (m_averageFrameTime < m_config.targetFrameTime * m_config.upscaleThreshold)
+			scale += m_config.step;
+
+		scale = glm::clamp(scale, m_config.minScale, m_config.maxScale);
+		if (scale == m_scale)
+			return false;
+
+		m_scale = scale;
+		m_cooldown = m_config.cooldownFrames;
+		return true;
+	}
+
+	void ResolutionScaler::SetScale(float scale)
+	{
+		m_scale = glm::clamp(scale, m_config.minScale, m_config.maxScale);
+	}
+
+	glm::ivec2 ResolutionScaler::GetRenderSize(const glm::ivec2& windowSize) const
+	{
+		if (m_fixedResolution.x > 0 && m_fixedResolution.y > 0)
+			return m_fixedResolution;
+
+		glm::ivec2 size = glm::ivec2(glm::vec2(windowSize) * m_scale + 0.5f);
+		return glm::max(size, glm::ivec2(1));
+	}
+
+	bool ResolutionScaler::ResizeTarget(RenderTarget& target, const glm::ivec2& windowSize, GLenum internalFormat, bool depthStencil) const
+	{
+		glm::ivec2 size = GetRenderSize(windowSize);
+		if (target.GetSize() == size && (!depthStencil || target.HasDepthStencil()))
+			return false;
+
+		depthStencil |= target.HasDepthStencil();
+		if (target.GetSize().x > 0)
+			target.Cleanup();
+
+		target.Create(size.x, size.y, internalFormat, depthStencil);
+
+		bool pixelated = m_config.pixelated || (m_fixedResolution.x > 0 && m_fixedResolution.y > 0);
+		target.GetTexture().SetPixelated(pixelated);
+		return true;
+	}
+
+}
@@ -20,6 +20,8 @@ namespace LittleEngine::Graphics
         layout (location = 1) in vec2 aTexCoord;
         layout (location = 2) in vec4 aColor;
         layout (location = 3) in float aTexIndex;
+        layout (location = 4) in float aDepth;
+        layout (location = 5) in float aClipIndex;
 
         out vec2 vTexCoord;
         out vec4 vColor;
@@ -27,13 +29,21 @@ namespace LittleEngine::Graphics
 
         uniform mat4 view;
         uniform mat4 projection;
+        uniform vec4 uClipRects[32];    // {min x, min y, max x, max y} in world space, 0 = unclipped
 
         void main()
         {
-            gl_Position = projection * view * vec4(aPos, 0.0, 1.0);
+            gl_Position = projection * view * vec4(aPos, aDepth, 1.0);
             vTexCoord = aTexCoord;
             vColor = aColor;
             vTexIndex = int(aTexIndex);
+
+            // distance to each side of the clip rect, the rasterizer cuts the quad where it is negative.
+            vec4 clipRect = uClipRects[int(aClipIndex)];
+            gl_ClipDistance[0] = aPos.x - clipRect.x;
+            gl_ClipDistance[1] = clipRect.z - aPos.x;
+            gl_ClipDistance[2] = aPos.y - clipRect.y;
+            gl_ClipDistance[3] = clipRect.w - aPos.y;
         } 
     )";
 
@@ -79,6 +89,8 @@ namespace LittleEngine::Graphics
     uniform sampler2D uTex14;
     uniform sampler2D uTex15;
 
+    uniform float uAlphaCutoff;    // alpha test of the opaque pass, 0 = disabled
+
     void main()
     {
         vec4 texColor;
@@ -101,6 +113,8 @@ namespace LittleEngine::Graphics
         else texColor = vec4(1.0, 0.0, 1.0, 1.0); // fallback magenta
 
         FragColor = vColor * texColor;
+        if (FragColor.a < uAlphaCutoff)
+            discard;
     }
 )";
 
@@ -132,6 +146,21 @@ namespace LittleEngine::Graphics
         }
 	}
 
+    void Shader::CreateCompute(const std::string& compute)
+    {
+        if (id != 0)
+        {
+            Utils::Logger::Warning("Shader::CreateCompute : Shader was already created.");
+            return;
+        }
+        if (!GLAD_GL_VERSION_4_3)
+        {
+            Utils::Logger::Error("Shader::CreateCompute : compute shaders require OpenGL 4.3.");
+            return;
+        }
+        id = CreateComputeShaderFromCode(compute);
+    }
+
     void Shader::CreateDefault()
     {
         if (s_defaultShader == 0)
@@ -198,11 +227,21 @@ namespace LittleEngine::Graphics
         glUniform1i(glGetUniformLocation(id, name.c_str()), value);
     }    
     // ------------------------------------------------------------------------
+    void Shader::SetUInt(const std::string& name, unsigned int value) const
+    {
+        glUniform1ui(glGetUniformLocation(id, name.c_str()), value);
+    }
+    // ------------------------------------------------------------------------
     void Shader::SetIntArray(const std::string& name, int size, const int* array) const
     {
         glUniform1iv(glGetUniformLocation(id, name.c_str()), size, array);
     }
     // ------------------------------------------------------------------------
+    void Shader::SetVec4Array(const std::string& name, int size, const glm::vec4* array) const
+    {
+        glUniform4fv(glGetUniformLocation(id, name.c_str()), size, &array[0][0]);
+    }
+    // ------------------------------------------------------------------------
     void Shader::SetFloat(const std::string& name, float value) const
     {
         glUniform1f(glGetUniformLocation(id, name.c_str()), value);
@@ -366,6 +405,29 @@ namespace LittleEngine::Graphics
         return id;
     }
 
+    GLuint Shader::CreateComputeShaderFromCode(const std::string& computeCode)
+    {
+        const char* cShaderCode = computeCode.c_str();
+
+        GLuint compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        CheckCompileErrors(compute, "COMPUTE");
+
+        GLuint id = glCreateProgram();
+        glAttachShader(id, compute);
+        glLinkProgram(id);
+        CheckCompileErrors(id, "PROGRAM");
+        glDeleteShader(compute);
+
+        GLenum err = glGetError();
+        if (err != GL_NO_ERROR) {
+            Utils::Logger::Error("OpenGL Error in Shader::CreateComputeShaderFromCode - Code: " + std::to_string(err));
+        }
+
+        return id;
+    }
+
 #pragma endregion
 
 }
\ No newline at end of file
@@ -0,0 +1,570 @@
+#include "LittleEngine/Graphics/sprite_instance_renderer.h"
+
+#include "LittleEngine/Utils/logger.h"
+
+#include <algorithm>
+
+
+namespace LittleEngine::Graphics
+{
+
+#pragma region Shaders
+
+	static const unsigned int s_cullGroupSize = 256;	// must match local_size_x of the culling shaders
+
+	// sprite storage and visibility test shared by the culling shaders.
+	const std::string spriteCullCommon = R"(
+		#version 430 core
+		layout(local_size_x = 256) in;
+
+		struct Sprite
+		{
+			vec4 rect;
+			vec4 uv;
+			vec4 color;
+		};
+
+		layout(std430, binding = 0) readonly buffer Sprites { Sprite sprites[]; };
+		layout(std430, binding = 2) buffer Groups { uint groupValues[]; };
+
+		uniform uint uSpriteCount;
+		uniform vec4 uViewRect;		// {min x, min y, max x, max y}
+
+		shared uint sPrefix[256];
+
+		bool IsVisible(uint i)
+		{
+			if (i >= uSpriteCount)
+				return false;
+			vec4 r = sprites[i].rect;
+			if (r.z == 0.0 || r.w == 0.0)
+				return false;	// removed sprite
+			vec2 minPos = min(r.xy, r.xy + r.zw);
+			vec2 maxPos = max(r.xy, r.xy + r.zw);
+			return minPos.x <= uViewRect.z && maxPos.x >= uViewRect.x && minPos.y <= uViewRect.w && maxPos.y >= uViewRect.y;
+		}
+
+		// inclusive prefix sum of the visibility in the work group, returns the exclusive prefix of this invocation.
+		uint LocalPrefix(bool visible)
+		{
+			uint lid = gl_LocalInvocationID.x;
+			uint value = visible ? 1u : 0u;
+			sPrefix[lid] = value;
+			barrier();
+			for (uint offset = 1u; offset < 256u; offset <<= 1)
+			{
+				uint other = lid >= offset ? sPrefix[lid - offset] : 0u;
+				barrier();
+				sPrefix[lid] += other;
+				barrier();
+			}
+			return sPrefix[lid] - value;
+		}
+	)";
+
+	// pass 1: number of visible sprites of each work group.
+	const std::string spriteCountShader = R"(
+		void main()
+		{
+			LocalPrefix(IsVisible(gl_GlobalInvocationID.x));
+			if (gl_LocalInvocationID.x == 255u)
+				groupValues[gl_WorkGroupID.x] = sPrefix[255];
+		}
+	)";
+
+	// pass 2 (single work group): group counts -> group offsets, and instance count of the indirect command.
+	const std::string spriteScanShader = R"(
+		#version 430 core
+		layout(local_size_x = 256) in;
+
+		layout(std430, binding = 2) buffer Groups { uint groupValues[]; };
+		layout(std430, binding = 3) buffer Command
+		{
+			uint count;
+			uint instanceCount;
+			uint firstIndex;
+			uint baseVertex;
+			uint baseInstance;
+		};
+
+		uniform uint uGroupCount;
+
+		shared uint sPrefix[256];
+		shared uint sTotal;
+
+		void main()
+		{
+			uint lid = gl_LocalInvocationID.x;
+			if (lid == 0u)
+				sTotal = 0u;
+			barrier();
+
+			for (uint base = 0u; base < uGroupCount; base += 256u)
+			{
+				uint i = base + lid;
+				uint value = i < uGroupCount ? groupValues[i] : 0u;
+				sPrefix[lid] = value;
+				barrier();
+				for (uint offset = 1u; offset < 256u; offset <<= 1)
+				{
+					uint other = lid >= offset ? sPrefix[lid - offset] : 0u;
+					barrier();
+					sPrefix[lid] += other;
+					barrier();
+				}
+
+				uint total = sTotal;
+				if (i < uGroupCount)
+					groupValues[i] = total + sPrefix[lid] - value;
+				barrier();
+				if (lid == 255u)
+					sTotal = total + sPrefix[255];
+				barrier();
+			}
+
+			if (lid == 0u)
+				instanceCount = sTotal;
+		}
+	)";
+
+	// pass 3: writes the index of each visible sprite, in submission order.
+	const std::string spriteCompactShader = R"(
+		layout(std430, binding = 1) writeonly buffer Visible { uint visible[]; };
+
+		void main()
+		{
+			bool isVisible = IsVisible(gl_GlobalInvocationID.x);
+			uint prefix = LocalPrefix(isVisible);
+			if (isVisible)
+				visible[groupValues[gl_WorkGroupID.x] + prefix] = gl_GlobalInvocationID.x;
+		}
+	)";
+
+	// GPU path: instances are read from the storage buffers.
+	const std::string spriteGpuVertexShader = R"(
+		#version 430 core
+		layout (location = 0) in vec2 aCorner;
+
+		struct Sprite
+		{
+			vec4 rect;
+			vec4 uv;
+			vec4 color;
+		};
+
+		layout(std430, binding = 0) readonly buffer Sprites { Sprite sprites[]; };
+		layout(std430, binding = 1) readonly buffer Visible { uint visible[]; };
+
+		uniform mat4 view;
+		uniform mat4 projection;
+
+		out vec2 vTexCoord;
+		out vec4 vColor;
+
+		void main()
+		{
+			Sprite s = sprites[visible[gl_InstanceID]];
+			gl_Position = projection * view * vec4(s.rect.xy + aCorner * s.rect.zw, 0.0, 1.0);
+			vTexCoord = mix(s.uv.xy, s.uv.zw, aCorner);
+			vColor = s.color;
+		}
+	)";
+
+	// CPU path: instances are vertex attributes.
+	const std::string spriteCpuVertexShader = R"(
+		#version 330 core
+		layout (location = 0) in vec2 aCorner;
+		layout (location = 1) in vec4 aRect;
+		layout (location = 2) in vec4 aUV;
+		layout (location = 3) in vec4 aColor;
+
+		uniform mat4 view;
+		uniform mat4 projection;
+
+		out vec2 vTexCoord;
+		out vec4 vColor;
+
+		void main()
+		{
+			gl_Position = projection * view * vec4(aRect.xy + aCorner * aRect.zw, 0.0, 1.0);
+			vTexCoord = mix(aUV.xy, aUV.zw, aCorner);
+			vColor = aColor;
+		}
+	)";
+
+	const std::string spriteFragmentShader = R"(
+		#version 330 core
+		out vec4 FragColor;
+
+		in vec2 vTexCoord;
+		in vec4 vColor;
+
+		uniform sampler2D uTexture;
+
+		void main()
+		{
+			FragColor = vColor * texture(uTexture, vTexCoord);
+		}
+	)";
+
+#pragma endregion
+
+
+#pragma region Initialization / lifetime management.
+
+	void SpriteInstanceRenderer::Initialize(const Texture& texture, size_t capacity, bool forceCpuCulling)
+	{
+		if (m_initialized)
+		{
+			Utils::Logger::Warning("SpriteInstanceRenderer::Initialize : already initialized.");
+			return;
+		}
+
+		m_texture = texture;
+		m_gpuCulling = GLAD_GL_VERSION_4_3 && !forceCpuCulling;
+
+		// unit quad, corners in [0, 1]
+		const float corners[] = { 0.f, 0.f,  1.f, 0.f,  1.f, 1.f,  0.f, 1.f };
+		const unsigned int indices[] = { 0, 1, 2, 0, 2, 3 };
+
+		glGenVertexArrays(1, &m_VAO);
+		glGenBuffers(1, &m_quadVBO);
+		glGenBuffers(1, &m_EBO);
+
+		glBindVertexArray(m_VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+		if (m_gpuCulling)
+		{
+			glGenBuffers(1, &m_spriteSSBO);
+			glGenBuffers(1, &m_visibleSSBO);
+			glGenBuffers(1, &m_groupSSBO);
+			glGenBuffers(1, &m_indirectBuffer);
+
+			const GLuint command[5] = { 6, 0, 0, 0, 0 };
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(command), command, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+			m_countShader.CreateCompute(spriteCullCommon + spriteCountShader);
+			m_scanShader.CreateCompute(spriteScanShader);
+			m_compactShader.CreateCompute(spriteCullCommon + spriteCompactShader);
+			m_shader.Create(spriteGpuVertexShader, spriteFragmentShader, false);
+		}
+		else
+		{
+			// per-instance attributes
+			glGenBuffers(1, &m_instanceVBO);
+			glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, rect));
+			glEnableVertexAttribArray(1);
+			glVertexAttribDivisor(1, 1);
+			glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, uv));
+			glEnableVertexAttribArray(2);
+			glVertexAttribDivisor(2, 1);
+			glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, color));
+			glEnableVertexAttribArray(3);
+			glVertexAttribDivisor(3, 1);
+
+			m_shader.Create(spriteCpuVertexShader, spriteFragmentShader, false);
+		}
+
+		glBindVertexArray(0);
+
+		m_shader.Use();
+		m_shader.SetInt("uTexture", 0);
+
+		m_initialized = true;
+
+		m_sprites.reserve(capacity);
+		Reserve(std::max<size_t>(capacity, 1));
+	}
+
+	void SpriteInstanceRenderer::Shutdown()
+	{
+		if (!m_initialized)
+			return;
+
+		glDeleteVertexArrays(1, &m_VAO);
+		glDeleteBuffers(1, &m_quadVBO);
+		glDeleteBuffers(1, &m_EBO);
+		m_VAO = m_quadVBO = m_EBO = 0;
+
+		if (m_gpuCulling)
+		{
+			glDeleteBuffers(1, &m_spriteSSBO);
+			glDeleteBuffers(1, &m_visibleSSBO);
+			glDeleteBuffers(1, &m_groupSSBO);
+			glDeleteBuffers(1, &m_indirectBuffer);
+			m_spriteSSBO = m_visibleSSBO = m_groupSSBO = m_indirectBuffer = 0;
+
+			m_countShader.Cleanup();
+			m_scanShader.Cleanup();
+			m_compactShader.Cleanup();
+		}
+		else
+		{
+			glDeleteBuffers(1, &m_instanceVBO);
+			m_instanceVBO = 0;
+		}
+		m_shader.Cleanup();
+
+		m_sprites.clear();
+		m_freeIds.clear();
+		m_removed.clear();
+		m_visibleSprites.clear();
+		m_capacity = 0;
+		m_dirtyBegin = m_dirtyEnd = 0;
+
+		m_initialized = false;
+	}
+
+	void SpriteInstanceRenderer::Reserve(size_t capacity)
+	{
+		if (capacity <= m_capacity)
+			return;
+
+		m_capacity = capacity;
+
+		if (!m_gpuCulling)
+			return;	// the visible sprites are streamed each frame
+
+		size_t groupCount = (capacity + s_cullGroupSize - 1) / s_cullGroupSize;
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_spriteSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(SpriteInstance), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibleSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_groupSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, groupCount * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// the storage was reallocated, everything has to be uploaded again.
+		m_dirtyBegin = 0;
+		m_dirtyEnd = m_sprites.size();
+	}
+
+#pragma endregion
+
+
+#pragma region Sprite management
+
+	SpriteInstanceId SpriteInstanceRenderer::Add(const SpriteInstance& sprite)
+	{
+		SpriteInstanceId id;
+		if (!m_freeIds.empty())
+		{
+			id = m_freeIds.back();
+			m_freeIds.pop_back();
+			m_sprites[id] = sprite;
+			m_removed[id] = 0;
+		}
+		else
+		{
+			id = static_cast<SpriteInstanceId>(m_sprites.size());
+			m_sprites.push_back(sprite);
+			m_removed.push_back(0);
+			if (m_sprites.size() > m_capacity)
+				Reserve(m_capacity * 2);
+		}
+
+		MarkDirty(id);
+		return id;
+	}
+
+	void SpriteInstanceRenderer::Update(SpriteInstanceId id, const SpriteInstance& sprite)
+	{
+		if (id >= m_sprites.size() || m_removed[id])
+		{
+			Utils::Logger::Warning("SpriteInstanceRenderer::Update : invalid sprite id " + std::to_string(id) + ".");
+			return;
+		}
+		m_sprites[id] = sprite;
+		MarkDirty(id);
+	}
+
+	void SpriteInstanceRenderer::Remove(SpriteInstanceId id)
+	{
+		if (id >= m_sprites.size())
+		{
+			Utils::Logger::Warning("SpriteInstanceRenderer::Remove : invalid sprite id " + std::to_string(id) + ".");
+			return;
+		}
+		if (m_removed[id])	// a second free would hand the id to two sprites
+		{
+			Utils::Logger::Warning("SpriteInstanceRenderer::Remove : sprite " + std::to_string(id) + " already removed.");
+			return;
+		}
+
+		// an empty rect is always culled.
+		m_sprites[id].rect = { 0, 0, 0, 0 };
+		m_removed[id] = 1;
+		m_freeIds.push_back(id);
+		MarkDirty(id);
+	}
+
+	void SpriteInstanceRenderer::Clear()
+	{
+		m_sprites.clear();
+		m_freeIds.clear();
+		m_removed.clear();
+		m_dirtyBegin = m_dirtyEnd = 0;
+	}
+
+	void SpriteInstanceRenderer::MarkDirty(size_t index)
+	{
+		if (m_dirtyBegin == m_dirtyEnd)
+		{
+			m_dirtyBegin = index;
+			m_dirtyEnd = index + 1;
+			return;
+		}
+		m_dirtyBegin = std::min(m_dirtyBegin, index);
+		m_dirtyEnd = std::max(m_dirtyEnd, index + 1);
+	}
+
+	void SpriteInstanceRenderer::UploadDirtyRange()
+	{
+		m_dirtyEnd = std::min(m_dirtyEnd, m_sprites.size());
+		if (m_dirtyBegin >= m_dirtyEnd)
+		{
+			m_dirtyBegin = m_dirtyEnd = 0;
+			return;
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_spriteSSBO);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, m_dirtyBegin * sizeof(SpriteInstance),
+			(m_dirtyEnd - m_dirtyBegin) * sizeof(SpriteInstance), &m_sprites[m_dirtyBegin]);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		m_dirtyBegin = m_dirtyEnd = 0;
+	}
+
+#pragma endregion
+
+
+#pragma region Culling and drawing
+
+	void SpriteInstanceRenderer::Draw(Renderer* renderer)
+	{
+		if (!m_initialized)
+		{
+			Utils::Logger::Warning("SpriteInstanceRenderer::Draw : not initialized.");
+			return;
+		}
+		if (!renderer)
+		{
+			Utils::Logger::Warning("SpriteInstanceRenderer::Draw : Renderer is null.");
+			return;
+		}
+
+		renderer->Flush();	// sprites are drawn over what was queued before.
+
+		m_lastVisibleCount = 0;
+		if (m_sprites.empty())
+			return;
+
+		const Camera& camera = renderer->GetCamera();
+
+		m_shader.Use();
+		m_shader.SetMat4("view", camera.GetViewMatrix());
+		m_shader.SetMat4("projection", camera.GetProjectionMatrix());
+		m_texture.Bind(0);
+
+		if (m_gpuCulling)
+			CullAndDrawGpu(camera.GetVisibleBounds());
+		else
+			CullAndDrawCpu(camera.GetVisibleBounds());
+
+		glBindVertexArray(0);
+		m_texture.Unbind(0);
+		renderer->shader.Use();
+	}
+
+	void SpriteInstanceRenderer::CullAndDrawGpu(const glm::vec4& viewRect)
+	{
+		UploadDirtyRange();
+
+		GLuint spriteCount = static_cast<GLuint>(m_sprites.size());
+		GLuint groupCount = (spriteCount + s_cullGroupSize - 1) / s_cullGroupSize;
+
+		// reset the indirect command, the instance count is written by the scan pass.
+		const GLuint command[5] = { 6, 0, 0, 0, 0 };
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), command);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_spriteSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_visibleSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_groupSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_indirectBuffer);
+
+		m_countShader.Use();
+		m_countShader.SetUInt("uSpriteCount", spriteCount);
+		m_countShader.SetVec4("uViewRect", viewRect);
+		glDispatchCompute(groupCount, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		m_scanShader.Use();
+		m_scanShader.SetUInt("uGroupCount", groupCount);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		m_compactShader.Use();
+		m_compactShader.SetUInt("uSpriteCount", spriteCount);
+		m_compactShader.SetVec4("uViewRect", viewRect);
+		glDispatchCompute(groupCount, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+		m_shader.Use();
+		glBindVertexArray(m_VAO);
+		glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	void SpriteInstanceRenderer::CullAndDrawCpu(const glm::vec4& viewRect)
+	{
+		m_visibleSprites.clear();
+		for (const auto& sprite : m_sprites)
+		{
+			const glm::vec4& r = sprite.rect;
+			if (r.z == 0.f || r.w == 0.f)
+				continue;	// removed sprite
+
+			glm::vec2 minPos = glm::min(glm::vec2(r.x, r.y), glm::vec2(r.x + r.z, r.y + r.w));
+			glm::vec2 maxPos = glm::max(glm::vec2(r.x, r.y), glm::vec2(r.x + r.z, r.y + r.w));
+			if (minPos.x <= viewRect.z && maxPos.x >= viewRect.x && minPos.y <= viewRect.w && maxPos.y >= viewRect.y)
+				m_visibleSprites.push_back(sprite);
+		}
+
+		m_dirtyBegin = m_dirtyEnd = 0;	// nothing is kept on the GPU
+		m_lastVisibleCount = static_cast<unsigned int>(m_visibleSprites.size());
+		if (m_visibleSprites.empty())
+			return;
+
+		glBindVertexArray(m_VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, m_visibleSprites.size() * sizeof(SpriteInstance), m_visibleSprites.data(), GL_STREAM_DRAW);
+		glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(m_visibleSprites.size()));
+	}
+
+	unsigned int SpriteInstanceRenderer::GetVisibleCount() const
+	{
+		if (!m_gpuCulling || !m_initialized || m_sprites.empty())
+			return m_lastVisibleCount;
+
+		GLuint instanceCount = 0;
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, sizeof(GLuint), sizeof(GLuint), &instanceCount);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		return instanceCount;
+	}
+
+#pragma endregion
+
+}
@@ -43,6 +43,9 @@ namespace LittleEngine::Graphics
             baseFormat = GL_RGBA;
             break;
         case GL_RED:
+        case GL_R8:
+        case GL_R16F:
+        case GL_R32F:
             baseFormat = GL_RED;
             break;
         default:
@@ -51,11 +54,13 @@ namespace LittleEngine::Graphics
             break;
         }
         // For HDR formats like GL_RGB16F, you use GL_RGB and GL_FLOAT for type
-        if (internalFormat == GL_RGB16F || internalFormat == GL_RGBA16F)
+        if (internalFormat == GL_RGB16F || internalFormat == GL_RGBA16F || internalFormat == GL_R16F || internalFormat == GL_R32F)
             type = GL_FLOAT;
 
 
         glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, baseFormat, type, NULL);
+        this->width = width;
+        this->height = height;
         
 
         if (internalFormat == GL_RED)
@@ -206,6 +211,18 @@ namespace LittleEngine::Graphics
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    void Texture::SetPixelated(bool pixelated) const
+    {
+        if (id == 0)
+            return;
+
+        Bind();
+        GLint filter = pixelated ? GL_NEAREST : GL_LINEAR;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        Unbind();
+    }
+
 #pragma endregion
 
 #pragma region Getters
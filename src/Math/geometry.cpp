@@ -124,6 +124,95 @@ namespace LittleEngine::Math
 	}
 
 
+	bool Polygon::IsConvex() const
+	{
+		size_t n = vertices.size();
+		if (n < 3)
+			return false;
+
+		float orientation = IsCounterClockwise() ? 1.f : -1.f;
+		for (size_t i = 0; i < n; ++i)
+		{
+			if (TriangleSignedArea(vertices[i], vertices[(i + 1) % n], vertices[(i + 2) % n]) * orientation < 0.f)
+				return false;
+		}
+		return true;
+	}
+
+	bool Polygon::FindTangents(const glm::vec2& point, size_t& first, size_t& last) const
+	{
+		int n = static_cast<int>(vertices.size());
+		if (n < 3)
+			return false;
+
+		auto vertex = [&](int i) -> const glm::vec2& { return vertices[(i % n + n) % n]; };
+		// side of vertex i relative to the line from the point through vertex j
+		auto above = [&](int i, int j) { return TriangleSignedArea(point, vertex(j), vertex(i)) < 0.f; };
+		auto below = [&](int i, int j) { return TriangleSignedArea(point, vertex(j), vertex(i)) > 0.f; };
+
+		// binary search over the chain [a, b] for the vertex whose two neighbours are on the same side
+		// of the line from the point (D. Sunday, tangents from a point to a convex polygon).
+		const int maxIterations = 64;
+		auto tangent = [&](bool upper) -> int
+		{
+			if (upper ? (below(1, 0) && !above(-1, 0)) : (above(-1, 0) && !below(1, 0)))
+				return 0;
+
+			int a = 0;
+			int b = n;
+			for (int iteration = 0; iteration < maxIterations; ++iteration)
+			{
+				int c = (a + b) / 2;
+				bool downC = below(c + 1, c);
+				if (upper ? (downC && !above(c - 1, c)) : (above(c - 1, c) && !downC))
+					return c;
+
+				bool selectFirstHalf;
+				if (upper)
+				{
+					if (above(a + 1, a))
+						selectFirstHalf = downC || above(a, c);
+					else
+						selectFirstHalf = downC && below(a, c);
+				}
+				else
+				{
+					if (below(a + 1, a))
+						selectFirstHalf = !downC || below(a, c);
+					else
+						selectFirstHalf = !downC && above(a, c);
+				}
+
+				if (selectFirstHalf)
+					b = c;
+				else
+					a = c;
+			}
+			return -1;	// degenerate polygon
+		};
+
+		int upper = tangent(true);
+		int lower = tangent(false);
+		if (upper < 0 || lower < 0 || upper == lower)
+			return false;
+
+		// the facing chain starts at the tangent followed by a facing edge.
+		auto facing = [&](int i) { return ThreePointOrientation(vertex(i), vertex(i + 1), point) == 1; };
+		if (facing(upper) && !facing(upper - 1) && facing(lower - 1) && !facing(lower))
+		{
+			first = upper;
+			last = lower;
+			return true;
+		}
+		if (facing(lower) && !facing(lower - 1) && facing(upper - 1) && !facing(upper))
+		{
+			first = lower;
+			last = upper;
+			return true;
+		}
+		return false;	// inside, on an edge or degenerate: not a valid silhouette
+	}
+
 	std::vector<Edge> Polygon::GetEdges() const
 	{
 		std::vector<Edge> edges;
@@ -136,4 +225,89 @@ namespace LittleEngine::Math
 		return edges;
 	}
 
+	AABB Polygon::GetBounds() const
+	{
+		if (vertices.empty())
+			return {};
+
+		AABB bounds = { vertices[0], vertices[0] };
+		for (const glm::vec2& vertex : vertices)
+		{
+			bounds.min = glm::min(bounds.min, vertex);
+			bounds.max = glm::max(bounds.max, vertex);
+		}
+		return bounds;
+	}
+
+	bool Polygon::Contains(const glm::vec2& point) const
+	{
+		bool inside = false;
+		for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
+		{
+			const glm::vec2& a = vertices[i];
+			const glm::vec2& b = vertices[j];
+			if ((a.y > point.y) != (b.y > point.y) &&
+				point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x)
+				inside = !inside;
+		}
+		return inside;
+	}
+
+	void Polygon::Triangulate(std::vector<glm::vec2>& triangles) const
+	{
+		if (vertices.size() < 3)
+			return;
+
+		// convex vertices have the sign of the polygon orientation.
+		float orientation = IsCounterClockwise() ? 1.f : -1.f;
+
+		std::vector<size_t> remaining(vertices.size());
+		for (size_t i = 0; i < remaining.size(); ++i)
+			remaining[i] = i;
+
+		// clip an ear (convex vertex whose triangle contains no other vertex) until a triangle is left.
+		while (remaining.size() > 3)
+		{
+			size_t count = remaining.size();
+			bool clipped = false;
+			for (size_t i = 0; i < count && !clipped; ++i)
+			{
+				const glm::vec2& a = vertices[remaining[(i + count - 1) % count]];
+				const glm::vec2& b = vertices[remaining[i]];
+				const glm::vec2& c = vertices[remaining[(i + 1) % count]];
+
+				if (TriangleSignedArea(a, b, c) * orientation <= 0.f)
+					continue; // reflex or flat vertex
+
+				bool isEar = true;
+				for (size_t j = 0; j < count && isEar; ++j)
+				{
+					const glm::vec2& p = vertices[remaining[j]];
+					if (&p == &a || &p == &b || &p == &c)
+						continue;
+					isEar = TriangleSignedArea(a, b, p) * orientation < 0.f || TriangleSignedArea(b, c, p) * orientation < 0.f || TriangleSignedArea(c, a, p) * orientation < 0.f;
+				}
+
+				if (!isEar)
+					continue;
+
+				triangles.push_back(a);
+				triangles.push_back(b);
+				triangles.push_back(c);
+				remaining.erase(remaining.begin() + i);
+				clipped = true;
+			}
+
+			if (!clipped)
+			{
+				Utils::Logger::Warning("Polygon::Triangulate : no ear found, the polygon is degenerate or self-intersecting.");
+				return;
+			}
+		}
+
+		triangles.push_back(vertices[remaining[0]]);
+		triangles.push_back(vertices[remaining[1]]);
+		triangles.push_back(vertices[remaining[2]]);
+	}
+
 } // namespace LittleEngine
\ No newline at end of file
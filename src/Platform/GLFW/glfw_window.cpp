@@ -131,6 +131,19 @@ namespace LittleEngine::Platform
 		glfwSwapBuffers(m_window); // Swap front and back buffers
 	}
 
+	void GlfwWindow::WaitEvents(double timeout)
+	{
+		if (timeout > 0.0)
+			glfwWaitEventsTimeout(timeout);	// processes the events, callbacks are called from here
+		else
+			glfwWaitEvents();
+	}
+
+	void GlfwWindow::PostEmptyEvent()
+	{
+		glfwPostEmptyEvent();
+	}
+
 
 
 	void GlfwWindow::SetWindowTitle(const std::string& title)
@@ -249,6 +262,7 @@ namespace LittleEngine::Platform
 		glfwSetWindowSizeCallback(m_window, [](GLFWwindow* window, int width, int height)
 			{
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 				state.width = width;
 				state.height = height;
 				if (state.windowResizeCallback)
@@ -259,6 +273,7 @@ namespace LittleEngine::Platform
 			{
 				bool focus = focused == GLFW_TRUE;
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 				if (state.windowFocusCallback)
 					state.windowFocusCallback(focus);
 
@@ -269,6 +284,7 @@ namespace LittleEngine::Platform
 		glfwSetWindowCloseCallback(m_window, [](GLFWwindow* window)
 			{
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 				if (state.windowCloseCallback)
 					state.windowCloseCallback();
 			});
@@ -278,6 +294,7 @@ namespace LittleEngine::Platform
 				float x = static_cast<float>(xpos);
 				float y = static_cast<float>(ypos);
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 				if (state.mouseMoveCallback)
 					state.mouseMoveCallback(x, y);
 
@@ -295,6 +312,7 @@ namespace LittleEngine::Platform
 				float x = static_cast<float>(xoffset);
 				float y = static_cast<float>(yoffset);
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 				if (state.mouseScrollCallback)
 					state.mouseScrollCallback(x, y);
 
@@ -310,6 +328,7 @@ namespace LittleEngine::Platform
 		glfwSetMouseButtonCallback(m_window, [](GLFWwindow* window, int button, int action, int mods)
 			{
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 				Input::MouseButton mb = GlfwUtils::MouseButtonFromGlfw(button); // Convert GLFW button to Input::MouseButton
 				Input::InputEventType type = action == GLFW_PRESS ? Input::InputEventType::Pressed : Input::InputEventType::Released;
 				if (state.mouseButtonCallback)
@@ -327,6 +346,7 @@ namespace LittleEngine::Platform
 		glfwSetKeyCallback(m_window, [](GLFWwindow* window, int key, int scancode, int action, int mods)
 			{
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 				Input::KeyCode k = GlfwUtils::KeyFromGlfw(key); // Convert GLFW key to Input::KeyCode
 				Input::InputEventType type;
 				if (action == GLFW_PRESS || action == GLFW_REPEAT)
@@ -349,6 +369,7 @@ namespace LittleEngine::Platform
 		glfwSetCharCallback(m_window, [](GLFWwindow* window, unsigned int codepoint)
 			{
 				WindowState& state = *static_cast<WindowState*>(glfwGetWindowUserPointer(window));
+				state.eventCount++;
 
 				if (state.charCallback)
 					state.charCallback(codepoint);
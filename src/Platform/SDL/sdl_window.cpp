@@ -151,6 +151,9 @@ namespace LittleEngine::Platform
 			// forward events to ImGui
 			ImGui_ImplSDL3_ProcessEvent(&event);
 
+			if (event.type < SDL_EVENT_USER)
+				m_state.eventCount++;	// user events only wake up WaitEvents
+
 			// Handle SDL events
 			switch (event.type)
 			{
@@ -246,6 +249,22 @@ namespace LittleEngine::Platform
 		SDL_GL_SwapWindow(m_window);
 	}
 
+	void SdlWindow::WaitEvents(double timeout)
+	{
+		// the events are left in the queue, they are processed by the next OnUpdate.
+		if (timeout > 0.0)
+			SDL_WaitEventTimeout(nullptr, static_cast<Sint32>(timeout * 1000.0));
+		else
+			SDL_WaitEvent(nullptr);
+	}
+
+	void SdlWindow::PostEmptyEvent()
+	{
+		SDL_Event event = {};
+		event.type = SDL_EVENT_USER;
+		SDL_PushEvent(&event);
+	}
+
 
 
 	void SdlWindow::SetWindowTitle(const std::string& title)
@@ -19,6 +19,7 @@ namespace LittleEngine::Utils
 
 	bool Logger::s_logToFile = false;
 	std::ofstream Logger::s_logFileStream;
+	std::mutex Logger::s_mutex;
 
 
 
@@ -33,27 +34,33 @@ namespace LittleEngine::Utils
 
 	void Logger::SetLogFile(const std::filesystem::path& filePath)
 	{
-
-		if (s_logFileStream.is_open())
-		{
-			s_logFileStream.close();
-		}
 		if (!filePath.empty())
 		{
 			auto dir = filePath.parent_path();
-			FileSystem::CreateDirectories(dir);
+			FileSystem::CreateDirectories(dir);	// may log, before the lock
+		}
 
-			s_logFileStream.open(filePath, std::ios::out | std::ios::app);
-			if (!s_logFileStream.is_open())
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+
+			if (s_logFileStream.is_open())
 			{
-				std::cerr << "Failed to open log file: " << filePath.string();
-				return;
+				s_logFileStream.close();
+			}
+			if (!filePath.empty())
+			{
+				s_logFileStream.open(filePath, std::ios::out | std::ios::app);
+				if (!s_logFileStream.is_open())
+				{
+					std::cerr << "Failed to open log file: " << filePath.string();
+					return;
+				}
+				s_logToFile = true;
+			}
+			else
+			{
+				s_logToFile = false;
 			}
-			s_logToFile = true;
-		}
-		else
-		{
-			s_logToFile = false;
 		}
 		
 		Info("Logger initialized. Logging to file: " + filePath.string());
@@ -62,11 +69,14 @@ namespace LittleEngine::Utils
 
 	void Logger::CloseLogFile()
 	{
-		if (s_logFileStream.is_open())
 		{
-			s_logFileStream.close();
+			std::lock_guard<std::mutex> lock(s_mutex);
+			if (s_logFileStream.is_open())
+			{
+				s_logFileStream.close();
+			}
+			s_logToFile = false;
 		}
-		s_logToFile = false;
 		Log(LogLevel::Info, "Log file cleared.");
 	}
 
@@ -85,6 +95,7 @@ namespace LittleEngine::Utils
 
 		std::string logMessage = GetTimestamp() + " " + levelStr + " " + message;
 
+		std::lock_guard<std::mutex> lock(s_mutex);	// messages of other threads are not interleaved
 
 #if DEVELOPMENT_BUILD == 1
 
@@ -0,0 +1,110 @@
+#include "LittleEngine/Utils/thread_pool.h"
+
+#include "LittleEngine/Utils/logger.h"
+
+#include <algorithm>
+
+
+namespace LittleEngine::Utils
+{
+
+	void ThreadPool::Initialize(unsigned int threadCount)
+	{
+		if (!m_threads.empty())
+		{
+			Logger::Warning("ThreadPool::Initialize : already initialized.");
+			return;
+		}
+
+		m_stop = false;
+		m_threads.reserve(threadCount);
+		for (unsigned int i = 0; i < threadCount; i++)
+			m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	void ThreadPool::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+
+		for (std::thread& thread : m_threads)
+			thread.join();
+		m_threads.clear();
+	}
+
+	void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, size_t)>& task, size_t minRange)
+	{
+		if (count == 0)
+			return;
+
+		minRange = std::max<size_t>(minRange, 1);
+		if (m_threads.empty() || count <= minRange)
+		{
+			task(0, count);
+			return;
+		}
+
+		{
+			// a late worker of the previous job may still be leaving it
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this] { return m_activeWorkers == 0; });
+
+			// a few ranges per thread, so a slow range does not keep the others waiting
+			size_t threadCount = m_threads.size() + 1;
+			m_task = &task;
+			m_count = count;
+			m_rangeSize = std::max(minRange, (count + threadCount * 4 - 1) / (threadCount * 4));
+			m_rangeCount = (count + m_rangeSize - 1) / m_rangeSize;
+			m_nextRange = 0;
+			m_generation++;
+		}
+		m_wake.notify_all();
+
+		RunRanges();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_activeWorkers == 0; });
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		unsigned int generation = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+				if (m_stop)
+					return;
+
+				generation = m_generation;
+				m_activeWorkers++;
+			}
+
+			RunRanges();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_activeWorkers == 0)
+					m_done.notify_all();
+			}
+		}
+	}
+
+	void ThreadPool::RunRanges()
+	{
+		while (true)
+		{
+			size_t range = m_nextRange.fetch_add(1);
+			if (range >= m_rangeCount)
+				return;
+
+			size_t begin = range * m_rangeSize;
+			(*m_task)(begin, std::min(begin + m_rangeSize, m_count));
+		}
+	}
+
+}
@@ -27,6 +27,7 @@
 #include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <atomic>
 
 
 
@@ -59,6 +60,13 @@ namespace LittleEngine
 	static const float s_updateTimeStep = 1.f / 60.f; // update step in seconds (60 FPS)
 	static float accumulatedTime = 0.f; // accumulated time for update steps
 	static float s_fps = 0.f; // frames per second
+	static float s_frameTime = 0.f; // duration of the last frame in seconds
+	static float s_frameWorkTime = 0.f; // duration of the last frame without the idle wait and the buffer swap
+
+	static bool s_idleRendering = false; // only render when something happened
+	static float s_idleTimeout = 0.5f; // maximum sleep duration in idle rendering mode
+	static bool s_animating = false; // forces continuous rendering in idle rendering mode
+	static std::atomic<bool> s_redrawRequested = true; // the first frame is always rendered
 
 
 #pragma region Library Management
@@ -103,6 +111,9 @@ namespace LittleEngine
 		windowConfig.iconPath = config.iconPath;
 		s_window = Platform::MakeWindow(windowConfig);
 
+		s_idleRendering = config.idleRendering;
+		s_idleTimeout = config.idleTimeout;
+
 		// TODO : where to put this?
 
 		// check if debug was initialized correctly.
@@ -152,11 +163,31 @@ namespace LittleEngine
 
 		int frameCount = 0;
 
+		unsigned int lastEventCount = s_window->GetEventCount();
+
 
 		// render loop
 		// -----------
 		while (!s_window->ShouldClose())
 		{
+			// IDLE
+			// -----
+			// nothing changed since the last frame: sleep until an event arrives or the timeout expires.
+			if (s_idleRendering && !s_animating && !s_redrawRequested && s_window->GetEventCount() == lastEventCount)
+			{
+				s_window->WaitEvents(s_idleTimeout);
+				if (s_window->ShouldClose())
+					break;
+
+				// the sleep is not simulated time: run a single update step for the woken frame.
+				lastTime = Clock::now() - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(s_updateTimeStep));
+				accumulatedTime = 0.f;
+			}
+			s_redrawRequested = false;
+			lastEventCount = s_window->GetEventCount();
+
+			TimePoint workStart = Clock::now();
+
 			frameCount++;			// TODO REMOVE THIS WHEN NOT NEEDED
 
 			// INIT
@@ -202,6 +233,7 @@ namespace LittleEngine
 
 			// Update game at fixed time step.
 			s_fps = 1.f / delta.count(); // update fps
+			s_frameTime = delta.count();
 			accumulatedTime += delta.count();
 			while (accumulatedTime >= s_updateTimeStep)
 			{
@@ -221,6 +253,9 @@ namespace LittleEngine
 			Platform::ImGuiRender();
 #endif
 
+			// the swap waits for vsync, it is not part of the work of the frame.
+			s_frameWorkTime = std::chrono::duration<float>(Clock::now() - workStart).count();
+
 			// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 			// -------------------------------------------------------------------------------
 			s_window->OnUpdate();
@@ -253,6 +288,16 @@ namespace LittleEngine
 		return s_fps;
 	}
 
+	float GetFrameTime()
+	{
+		return s_frameTime;
+	}
+
+	float GetFrameWorkTime()
+	{
+		return s_frameWorkTime;
+	}
+
 #pragma endregion
 
 
@@ -261,6 +306,34 @@ namespace LittleEngine
 		s_window->SetVsync(b);
 	}
 
+#pragma region Idle Rendering
+
+	void SetIdleRendering(bool enabled, float timeout)
+	{
+		s_idleRendering = enabled;
+		s_idleTimeout = timeout;
+		RequestRedraw();
+	}
+
+	void RequestRedraw()
+	{
+		if (s_redrawRequested.exchange(true))
+			return;
+
+		// wake up the main loop if it is sleeping.
+		if (s_idleRendering && s_window)
+			s_window->PostEmptyEvent();
+	}
+
+	void SetAnimating(bool animating)
+	{
+		s_animating = animating;
+		if (animating)
+			RequestRedraw();
+	}
+
+#pragma endregion
+
 
 
 }
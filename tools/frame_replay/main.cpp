@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////
+// frame_replay: replays a frame trace recorded with
+// Renderer::CaptureFrameCommands and times it.
+//
+// usage: frame_replay <trace file> [iterations] [--no-vsync]
+//////////////////////////////////////////////////
+
+#include "LittleEngine/little_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+using namespace LittleEngine;
+using Clock = std::chrono::high_resolution_clock;
+
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::printf("usage: frame_replay <trace file> [iterations] [--no-vsync]\n");
+		return 1;
+	}
+
+	const char* path = argv[1];
+	int iterations = 100;
+	bool vsync = true;
+	for (int i = 2; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--no-vsync") == 0)
+			vsync = false;
+		else
+			iterations = std::max(1, std::atoi(argv[i]));
+	}
+
+	Graphics::FrameTrace trace;
+
+	EngineConfig config;
+	config.title = "frame_replay";
+	config.vsync = vsync;
+	config.windowMode = WindowMode::FixedWindowed;
+
+	// the trace is loaded once to get the window size, textures are created after the context.
+	if (!trace.Load(path))
+		return 1;
+	config.windowWidth = std::max(trace.screenSize.x, 1);
+	config.windowHeight = std::max(trace.screenSize.y, 1);
+
+	if (Initialize(config) != 0)
+		return 1;
+
+	{
+		Graphics::Camera camera;
+		camera.viewportSize = GetWindowSize();
+
+		Graphics::Renderer renderer;
+		renderer.Initialize(camera, GetWindowSize());
+
+		Graphics::FrameTracePlayer player;
+		player.Initialize(trace);
+
+		std::printf("%s: %zu commands, %zu quads, %zu textures, %zu targets\n", path,
+			trace.commands.size(), trace.quads.size(), trace.textures.size(), trace.targets.size());
+
+		std::vector<float> times;
+		times.reserve(iterations);
+
+		for (int i = 0; i < iterations && !GetWindow()->ShouldClose(); i++)
+		{
+			Clock::time_point start = Clock::now();
+
+			player.Replay(&renderer);
+			renderer.EndFrame();
+			glFinish();		// measure the GPU work, not only the submission
+
+			std::chrono::duration<float, std::milli> duration = Clock::now() - start;
+			times.push_back(duration.count());
+
+			GetWindow()->OnUpdate();
+		}
+
+		if (!times.empty())
+		{
+			std::sort(times.begin(), times.end());
+			float total = 0.f;
+			for (float t : times)
+				total += t;
+
+			std::printf("%zu replays: average %.3f ms, median %.3f ms, min %.3f ms, max %.3f ms\n", times.size(),
+				total / times.size(), times[times.size() / 2], times.front(), times.back());
+		}
+
+		player.Shutdown();
+		renderer.Shutdown();
+	}
+
+	Shutdown();
+	return 0;
+}